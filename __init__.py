@@ -11,6 +11,7 @@ from bpy.types import PropertyGroup
 from bpy.props import (
     BoolProperty,
     IntProperty,
+    FloatProperty,
     EnumProperty,
     FloatVectorProperty,
     StringProperty,
@@ -77,7 +78,12 @@ class SCENE_OT_SaveGeo(bpy.types.Operator):
 
         path = bpy.path.abspath(path)
 
-        opts = {}
+        opts = {
+            'compact_storage': o.compact_storage,
+            'weld': o.weld,
+            'weld_distance': o.weld_distance,
+            'reorder': o.reorder,
+        }
         res = exporter.export(path, ob, opts)
 
         if not res:
@@ -106,7 +112,10 @@ def update_geometry(o):
         return {"CANCELLED"}
 
     ob = o.id_data
-    opts = {'skip_normals': o.skip_normals and o.load_sequence}
+    opts = {
+        'skip_normals': o.skip_normals and o.load_sequence,
+        'pool_key': importer.pool_key(ob) if o.load_sequence else None,
+    }
 
     new_data = importer.import_(path, ob, opts)
 
@@ -138,6 +147,18 @@ def update_geometry(o):
 def frame_number_changed_cb(self, context):
     update_geometry(self)
 
+def load_sequence_changed_cb(self, context):
+    # single files don't keep a pooled detail
+    if not self.load_sequence:
+        importer.release_pool(keep=sequence_pool_keys())
+
+def sequence_pool_keys():
+    return {
+        importer.pool_key(x)
+        for x in bpy.data.objects
+        if x.houdini_io.active and x.houdini_io.load_sequence
+    }
+
 ###
 
 
@@ -192,6 +213,16 @@ class SCENE_PT_HoudiniIO(Panel):
         else:
             layout.prop(bpy.context.object.houdini_io, "filepath", text="File")
 
+        layout.prop(bpy.context.object.houdini_io, "compact_storage", text="Compact Storage (fp16 N, Cd, uv)")
+
+        row = layout.row()
+        row.prop(bpy.context.object.houdini_io, "weld", text="Weld Points")
+        sub = row.row()
+        sub.active = bpy.context.object.houdini_io.weld
+        sub.prop(bpy.context.object.houdini_io, "weld_distance", text="Distance")
+
+        layout.prop(bpy.context.object.houdini_io, "reorder", text="Reorder for Locality (smaller files)")
+
         layout.operator(SCENE_OT_LoadGeo.bl_idname, text="Load Geo")
         layout.operator(SCENE_OT_SaveGeo.bl_idname, text="Save Geo")
 
@@ -199,7 +230,7 @@ class SCENE_PT_HoudiniIO(Panel):
 
 class ObjectHoudiniIO(PropertyGroup):
     active: BoolProperty(name="Active", default=False)
-    load_sequence: BoolProperty(name="Load Sequence")
+    load_sequence: BoolProperty(name="Load Sequence", update=load_sequence_changed_cb)
     filepath_template: StringProperty(
         name="File Path Template",
         subtype="FILE_PATH",
@@ -211,6 +242,10 @@ class ObjectHoudiniIO(PropertyGroup):
         name="File Path", subtype="FILE_PATH", default="//geo.bgeo.sc"
     )
     skip_normals: BoolProperty(name="Skip Normals", default=True)
+    compact_storage: BoolProperty(name="Compact Storage", default=False)
+    weld: BoolProperty(name="Weld Points", default=False)
+    weld_distance: FloatProperty(name="Weld Distance", default=0.0001, min=0.0, precision=5)
+    reorder: BoolProperty(name="Reorder for Locality", default=False)
 
 
 classes = (
@@ -220,8 +255,15 @@ classes = (
     SCENE_OT_SaveGeo,
 )
 
+@bpy.app.handlers.persistent
+def global_load_pre_cb(*args):
+    importer.release_pool()
+
 @bpy.app.handlers.persistent
 def global_frame_change_cb(scene):
+    # deleted objects and inactive sequences release their pooled details
+    importer.release_pool(keep=sequence_pool_keys())
+
     for x in bpy.data.objects:
         hio = x.houdini_io
 
@@ -242,6 +284,9 @@ def register():
     if not global_frame_change_cb in bpy.app.handlers.frame_change_post:
         bpy.app.handlers.frame_change_post.append(global_frame_change_cb)
 
+    if not global_load_pre_cb in bpy.app.handlers.load_pre:
+        bpy.app.handlers.load_pre.append(global_load_pre_cb)
+
 
 def unregister():
     del bpy.types.Object.houdini_io
@@ -252,6 +297,9 @@ def unregister():
         unregister_class(cls)
 
     bpy.app.handlers.frame_change_post.remove(global_frame_change_cb)
+    bpy.app.handlers.load_pre.remove(global_load_pre_cb)
+
+    importer.release_pool()
 
 if __name__ == "__main__":
     register()
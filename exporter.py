@@ -8,124 +8,125 @@ from mathutils import Matrix
 from bpy_extras.io_utils import axis_conversion
 
 
-def export_mesh(path: str, me):
-    assert len(me.polygons) > 0, "Only supports polygons. No lines or points."
-
+def export_mesh(path: str, me, opts: dict):
     me.flip_normals()
     me.calc_normals_split()
 
-    geo = hio.Geometry()
-
-    vertices = np.empty(len(me.vertices) * 3, dtype=np.float32)
-    me.vertices.foreach_get("co", vertices)
-    vertices.shape = (len(me.vertices), 3)
+    # Everything is gathered into flat arrays, the detail is built and
+    # saved by hio.exportMesh without holding the GIL
+    positions = np.empty(len(me.vertices) * 3, dtype=np.float32)
+    me.vertices.foreach_get("co", positions)
+    positions.shape = (len(me.vertices), 3)
 
-    vertex_indices = np.empty(len(me.loops), dtype=np.int64)
-    me.loops.foreach_get("vertex_index", vertex_indices)
+    loop_points = np.empty(len(me.loops), dtype=np.int64)
+    me.loops.foreach_get("vertex_index", loop_points)
 
-    loop_total = np.empty(len(me.polygons), dtype=np.int64)
-    me.polygons.foreach_get("loop_total", loop_total)
+    loop_totals = np.empty(len(me.polygons), dtype=np.int64)
+    me.polygons.foreach_get("loop_total", loop_totals)
 
-    polys = geo.createPolygons(vertices, vertex_indices, loop_total, True)
-
-    ###
+    corner = {}
 
     normal = np.empty(len(me.loops) * 3, dtype=np.float32)
     me.loops.foreach_get("normal", normal)
     normal.shape = (len(me.loops), 3)
     normal *= -1
-
-    N = geo.addFloatAttrib(hio.AttribType.Vertex, "N", [0, 0, 0], hio.TypeInfo.Normal)
-    N.setAttribValue(normal)
+    corner["N"] = (normal, hio.TypeInfo.Normal)
 
     for uv_layer in me.uv_layers:
-        name = uv_layer.name
-
-        UV = geo.addFloatAttrib(
-            hio.AttribType.Vertex, name, [0, 0, 0], hio.TypeInfo.TextureCoord
-        )
-        data = np.empty(len(uv_layer.data) * 2, dtype=np.float32)
-        uv_layer.data.foreach_get("uv", data)
-        data.shape = (len(uv_layer.data), 2)
-        data = np.column_stack((data, np.zeros(data.shape[0])))
-        UV.setAttribValue(data)
+        data = np.zeros((len(uv_layer.data), 3), dtype=np.float32)
+        uv = np.empty(len(uv_layer.data) * 2, dtype=np.float32)
+        uv_layer.data.foreach_get("uv", uv)
+        data[:, :2] = uv.reshape((-1, 2))
+        corner[uv_layer.name] = (data, hio.TypeInfo.TextureCoord)
 
     for color_layer in me.vertex_colors:
-        name = color_layer.name
-
-        Cd = geo.addFloatAttrib(
-            hio.AttribType.Vertex, name, [0, 0, 0], hio.TypeInfo.Color
-        )
-        data = np.empty(len(color_layer.data) * 4, dtype=np.float64)
+        data = np.empty(len(color_layer.data) * 4, dtype=np.float32)
         color_layer.data.foreach_get("color", data)
         data.shape = (len(color_layer.data), 4)
-        data = data[:, :3]
-        Cd.setAttribValue(data)
+        corner[color_layer.name] = (data[:, :3], hio.TypeInfo.Color)
 
-    # TODO: fix material info
-    # if len(me.materials) > 0:
-    # 	data = np.empty(len(me.polygons), dtype=np.int32)
-    # 	me.polygons.foreach_get('material_index', data)
-    # 	material_index_attr = geo.addIntAttrib(hio.AttribType.Prim, "material_index", [0], hio.TypeInfo.Value)
-    # 	data.shape = (len(me.polygons), 1)
-    # 	material_index_attr.setAttribValue(data)
+    face_strings = {}
 
-    return geo
+    if len(me.materials) > 0:
+        data = np.empty(len(me.polygons), dtype=np.int32)
+        me.polygons.foreach_get("material_index", data)
 
+        table = [m.name if m else "" for m in me.materials]
+        face_strings["shop_materialpath"] = (table, data)
 
-def export_curve(path: str, cu):
-    geo = hio.Geometry()
+    # Edges not used by any face become two point open polygons
+    edges = np.empty(len(me.edges) * 2, dtype=np.int64)
+    me.edges.foreach_get("vertices", edges)
+    edges.shape = (len(me.edges), 2)
+
+    edge_index = np.empty(len(me.loops), dtype=np.int64)
+    me.loops.foreach_get("edge_index", edge_index)
+
+    loose = np.ones(len(me.edges), dtype=bool)
+    loose[edge_index] = False
+
+    arrays = {
+        "positions": positions,
+        "loop_points": loop_points,
+        "loop_totals": loop_totals,
+        "loose_edges": edges[loose],
+        "corner": corner,
+        "face_strings": face_strings,
+    }
+
+    options = {"storage_policies": storage_policies(opts)}
+
+    if opts.get("weld", False):
+        options["weld_tolerance"] = opts.get("weld_distance", 0.0)
 
-    for sp in cu.splines:
+    if opts.get("reorder", False):
+        options["reorder"] = True
 
-        if sp.type == "BEZIER":
-            pts = []
+    return hio.exportMesh(path, arrays, options)
 
-            if not sp.use_cyclic_u:
-                for i, p in enumerate(sp.bezier_points):
-                    if i > 0:
-                        pts.append((p.handle_left.x, p.handle_left.y, p.handle_left.z))
 
-                    pts.append((p.co.x, p.co.y, p.co.z))
+def export_curve(path: str, cu):
+    geo = hio.Geometry()
 
-                    if i < len(sp.bezier_points) - 1:
-                        pts.append(
-                            (p.handle_right.x, p.handle_right.y, p.handle_right.z)
-                        )
+    # Curves are created per type, Bezier splines first
+    bezier = [sp for sp in cu.splines if sp.type == "BEZIER"]
+    nurbs = [sp for sp in cu.splines if sp.type == "NURBS"]
 
-            else:
-                for i, p in enumerate(sp.bezier_points):
-                    pts.append((p.handle_left.x, p.handle_left.y, p.handle_left.z))
-                    pts.append((p.co.x, p.co.y, p.co.z))
-                    pts.append((p.handle_right.x, p.handle_right.y, p.handle_right.z))
+    if bezier:
+        counts = np.array([len(sp.bezier_points) for sp in bezier], dtype=np.int64)
+        closed = np.array([sp.use_cyclic_u for sp in bezier], dtype=np.int32)
 
-                pt = pts.pop(0)
-                pts.append(pt)
+        # (handle_left, anchor, handle_right) per bezier point
+        positions = np.empty((counts.sum(), 3, 3), dtype=np.float32)
 
-            prim = geo.createBezierCurve(len(pts), is_closed=sp.use_cyclic_u, order=4)
+        start = 0
+        for sp, n in zip(bezier, counts):
+            for i, key in enumerate(("handle_left", "co", "handle_right")):
+                data = np.empty(n * 3, dtype=np.float32)
+                sp.bezier_points.foreach_get(key, data)
+                positions[start:start + n, i] = data.reshape((n, 3))
+            start += n
 
-            arr = np.array(pts, dtype=np.float)
-            prim.setPositions(arr)
+        geo.createCurves(hio.PrimitiveTypes.BezierCurve, positions, counts,
+                         np.full(len(bezier), 4, dtype=np.int32), closed)
 
-        elif sp.type == "NURBS":
-            prim = geo.createNURBSCurve(
-                len(sp.points), is_closed=sp.use_cyclic_u, order=sp.order_u
-            )
+    if nurbs:
+        counts = np.array([len(sp.points) for sp in nurbs], dtype=np.int64)
+        orders = np.array([sp.order_u for sp in nurbs], dtype=np.int32)
+        closed = np.array([sp.use_cyclic_u for sp in nurbs], dtype=np.int32)
+        interp_ends = np.array([sp.use_endpoint_u for sp in nurbs], dtype=np.int32)
 
-            pts = np.empty(len(sp.points) * 4, dtype=np.float32)
-            sp.points.foreach_get("co", pts)
-            pts.shape = (len(sp.points), 4)
-            vertices = pts[:, :3].copy()
-            prim.setPositions(vertices)
+        pts = np.empty((counts.sum(), 4), dtype=np.float32)
 
-            Pw = geo.findPointAttrib("Pw")
-            if Pw == None:
-                Pw = geo.addFloatAttrib(
-                    hio.AttribType.Point, "Pw", [1], hio.TypeInfo.Value
-                )
+        start = 0
+        for sp, n in zip(nurbs, counts):
+            data = np.empty(n * 4, dtype=np.float32)
+            sp.points.foreach_get("co", data)
+            pts[start:start + n] = data.reshape((n, 4))
+            start += n
 
-            weights = pts[:, 3:].copy()
-            Pw.setAttribValue(weights, prim.vertexStartIndex())
+        geo.createCurves(hio.PrimitiveTypes.NURBSCurve, pts[:, :3], counts, orders, closed,
+                         weights=pts[:, 3], interp_ends=interp_ends)
 
     return geo
 
@@ -202,6 +203,18 @@ def export_grease_pencil(path: str, gp):
 ###
 
 
+def storage_policies(opts: dict):
+    # fp16 normals, colors and 2 component uvs
+    if not opts.get("compact_storage", False):
+        return {}
+
+    return {
+        hio.TypeInfo.Normal: (hio.AttribStorage.Real16, -1),
+        hio.TypeInfo.Color: (hio.AttribStorage.Real16, -1),
+        hio.TypeInfo.TextureCoord: (hio.AttribStorage.Real16, 2),
+    }
+
+
 def export(path: str, ob, opts):
 
     convert_to_mesh = False
@@ -224,8 +237,9 @@ def export(path: str, ob, opts):
 
     if isinstance(data, bpy.types.Mesh):
         me = data
-        geo = export_mesh(path, me)
+        ok = export_mesh(path, me, opts)
         bpy.data.meshes.remove(me)
+        return ok
 
     elif isinstance(data, bpy.types.Curve):
         cu = data
@@ -249,6 +263,9 @@ def export(path: str, ob, opts):
     if not geo:
         return False
 
+    for typeinfo, (storage, tuple_size) in storage_policies(opts).items():
+        geo.setStoragePolicy(typeinfo, storage, tuple_size)
+
     if not geo.save(path):
         return False
 
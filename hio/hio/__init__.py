@@ -34,7 +34,10 @@ del _mod_list
 
 AttribType = core.AttribType
 AttribData = core.AttribData
+AttribStorage = core.AttribStorage
 TypeInfo = core.TypeInfo
+PromoteMethod = core.PromoteMethod
+VolumeBorder = core.VolumeBorder
 PrimitiveTypes = core.PrimitiveTypes
 
 Vector2 = core.Vector2
@@ -47,6 +50,12 @@ Vertex = core.Vertex
 Polygon = core.Polygon
 BezierCurve = core.BezierCurve
 NURBSCurve = core.NURBSCurve
+ElementRange = core.ElementRange
+PointRange = core.PointRange
+PrimitiveRange = core.PrimitiveRange
 Geometry = core.Geometry
+GeometryPool = core.GeometryPool
+
+exportMesh = core.exportMesh
 
 __all__ = []
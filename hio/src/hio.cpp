@@ -1,19 +1,184 @@
 #include "hio.h"
 
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <limits>
 #include <iostream>
 #include <fstream>
 
 namespace hio {
 
+	static inline float cross2(const UT_Vector2& a, const UT_Vector2& b)
+	{
+		return a.x() * b.y() - a.y() * b.x();
+	}
+
+	// Ear clipping of a simple polygon given in 2D, appends n - 2 triangles of
+	// local indices. Falls back to a fan when no ear is found (degenerate input).
+	static void earClip(const std::vector<UT_Vector2>& pts, std::vector<int>& out_tris)
+	{
+		const int n = (int)pts.size();
+
+		auto orient = [&](int a, int b, int c)
+		{
+			return cross2(pts[b] - pts[a], pts[c] - pts[a]);
+		};
+
+		float area = 0;
+		for (int i = 0; i < n; i++)
+			area += cross2(pts[i], pts[(i + 1) % n]);
+		const float sign = area < 0 ? -1.0f : 1.0f;
+
+		std::vector<int> V(n);
+		std::iota(V.begin(), V.end(), 0);
+
+		while (V.size() > 3)
+		{
+			const int m = (int)V.size();
+			bool found = false;
+
+			for (int i = 0; i < m && !found; i++)
+			{
+				const int a = V[(i + m - 1) % m], b = V[i], c = V[(i + 1) % m];
+
+				if (orient(a, b, c) * sign <= 0)
+					continue;
+
+				bool is_ear = true;
+				for (int j = 0; j < m && is_ear; j++)
+				{
+					const int p = V[j];
+					if (p == a || p == b || p == c)
+						continue;
+
+					if (orient(a, b, p) * sign >= 0 && orient(b, c, p) * sign >= 0 && orient(c, a, p) * sign >= 0)
+						is_ear = false;
+				}
+
+				if (!is_ear)
+					continue;
+
+				out_tris.insert(out_tris.end(), { a, b, c });
+				V.erase(V.begin() + i);
+				found = true;
+			}
+
+			if (!found)
+				break;
+		}
+
+		for (size_t i = 1; i + 1 < V.size(); i++)
+			out_tris.insert(out_tris.end(), { V[0], V[i], V[i + 1] });
+	}
+
+	// Process wide totals for liveMemoryUsage(). Each Geometry only adds its
+	// own delta, so no detail is ever read by another thread.
+	static std::atomic<Size> live_geometries(0);
+	static std::atomic<Size> peak_geometries(0);
+	static std::atomic<int64> live_bytes(0);
+	static std::atomic<int64> peak_bytes(0);
+
+	template <typename T>
+	static void updatePeak(std::atomic<T>& peak, T value)
+	{
+		T prev = peak.load();
+		while (prev < value && !peak.compare_exchange_weak(prev, value)) {}
+	}
+
 	Geometry::Geometry()
 	{
 		_geo.clearAndDestroy();
+
+		updatePeak(peak_geometries, ++live_geometries);
+		trackMemoryUsage();
+	}
+
+	Geometry::~Geometry()
+	{
+		live_bytes -= _tracked_bytes;
+		--live_geometries;
+	}
+
+	void Geometry::trackMemoryUsage()
+	{
+		const int64 bytes = _geo.getMemoryUsage(true);
+		updatePeak(peak_bytes, live_bytes += bytes - _tracked_bytes);
+		_tracked_bytes = bytes;
 	}
 
 	void Geometry::clear()
 	{
 		_geo.clearAndDestroy();
+		trackMemoryUsage();
+	}
+
+	void Geometry::recycle()
+	{
+		_geo.stashAll();
+		trackMemoryUsage();
+	}
+
+	std::shared_ptr<Geometry> Geometry::clone() const
+	{
+		auto geo = std::make_shared<Geometry>();
+		geo->copyFrom(*this);
+		return geo;
+	}
+
+	void Geometry::copyFrom(const Geometry& other)
+	{
+		if (&other == this)
+			return;
+
+		_geo.replaceWith(other._geo);
+		_name_policies = other._name_policies;
+		_typeinfo_policies = other._typeinfo_policies;
+		_source_path = other._source_path;
+		trackMemoryUsage();
+	}
+
+	std::shared_ptr<Geometry> GeometryPool::acquire(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto& geo = _pool[key];
+		if (geo)
+			geo->recycle();
+		else
+			geo = std::make_shared<Geometry>();
+
+		return geo;
+	}
+
+	void GeometryPool::release(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_pool.erase(key);
+	}
+
+	void GeometryPool::clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_pool.clear();
+	}
+
+	Size GeometryPool::size() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _pool.size();
+	}
+
+	std::vector<std::string> GeometryPool::keys() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		std::vector<std::string> out;
+		for (const auto& it : _pool)
+			out.push_back(it.first);
+		return out;
 	}
 
     void Geometry::reverse()
@@ -48,6 +213,7 @@ namespace hio {
 		std::vector<hio::Point> arr;
 		for (int i = 0; i < size; i++)
 			arr.emplace_back(start + i);
+
 		return arr;
 	}
 
@@ -55,14 +221,14 @@ namespace hio {
 	{
 		auto start = _geo.appendPointBlock(size);
 
-		auto P = _geo.getP();
-		auto tuple = P->getAIFTuple();
-		auto res = tuple->setRange(P, _geo.getPointRange(), (float*)data, 0, 3);
-		assert(res);
+		// only the appended block is written
+		setTupleRange(_geo.getP(), start, size, (const float*)data);
 
 		std::vector<hio::Point> arr;
+		arr.reserve(size);
 		for (int i = 0; i < size; i++)
 			arr.emplace_back(start + i);
+
 		return arr;
 	}
 
@@ -99,240 +265,2385 @@ namespace hio {
 		return std::move(arr);
 	}
 
-	hio::Polygon Geometry::createPolygon(Size num_vertices, bool is_closed)
+	static void checkRange(Index start, Size& count, Size num_elements)
 	{
-		GEO_PrimPoly* poly = (GEO_PrimPoly*)GU_PrimPoly::build(&_geo, num_vertices, !is_closed, true);
-		return Polygon(poly);
-	}
+		if (count < 0)
+			count = num_elements - start;
 
+		if (start < 0 || count < 0 || start + count > num_elements)
+			throw std::runtime_error("Range out of bounds");
+	}
 
-	std::vector<hio::Polygon> Geometry::createPolygons(Size position_size, const Vector3* positions, Size vertex_counts_size, const Size* vertex_counts, bool closed)
+	static void checkSelection(const std::vector<Index>& indices, Size num_elements)
 	{
-		if (std::accumulate(vertex_counts, vertex_counts + vertex_counts_size, 0) != position_size)
-			throw std::runtime_error("Position and vertex count mismatch");
-
-		auto pts = createPoints(position_size, positions);
-
-		auto pt_it = pts.begin();
-
-		std::vector<hio::Polygon> arr;
-		arr.reserve(vertex_counts_size);
-
-		for (int x = 0; x < vertex_counts_size; x++)
+		for (Index i : indices)
 		{
-			auto count = vertex_counts[x];
+			if (i < 0 || i >= num_elements)
+				throw std::runtime_error("Index out of bounds");
+		}
+	}
 
-			auto poly = createPolygon();
-			poly.setIsClosed(closed);
-			arr.push_back(poly);
+	hio::PointRange Geometry::pointRange(Index start, Size count)
+	{
+		checkRange(start, count, getNumPoints());
+		return PointRange(this, start, count);
+	}
 
-			for (int i = 0; i < count; i++)
-			{
-				poly.addVertex(*pt_it);
-				pt_it++;
-			}
-		}
+	hio::PointRange Geometry::pointSelection(const std::vector<Index>& indices)
+	{
+		checkSelection(indices, getNumPoints());
+		return PointRange(this, indices);
+	}
 
-		return arr;
+	hio::PrimitiveRange Geometry::primRange(Index start, Size count)
+	{
+		checkRange(start, count, getNumPrimitives());
+		return PrimitiveRange(this, start, count);
 	}
 
-	std::vector<hio::Polygon> Geometry::createPolygons(Size position_size, const Vector3* positions, Size vertices_size, const Index* vertices, Size vertex_counts_size, const Size* vertex_counts, bool closed)
+	hio::PrimitiveRange Geometry::primSelection(const std::vector<Index>& indices)
 	{
-		auto pts = createPoints(position_size, positions);
+		checkSelection(indices, getNumPrimitives());
+		return PrimitiveRange(this, indices);
+	}
 
-		auto vtx_it = vertices;
+	hio::PointRange Geometry::createPointRange(Size size, const Vector3* data)
+	{
+		const Index start = getNumPoints();
 
-		std::vector<hio::Polygon> arr;
-		arr.reserve(vertex_counts_size);
+		const GA_Offset off = _geo.appendPointBlock(size);
+		setTupleRange(_geo.getP(), off, size, (const float*)data);
 
-		for (int x = 0; x < vertex_counts_size; x++)
-		{
-			auto count = vertex_counts[x];
+		return PointRange(this, start, size);
+	}
 
-			auto poly = createPolygon();
-			poly.setIsClosed(closed);
-			arr.push_back(poly);
+	//////////////////////////////////////////////////////////////////////////
 
-			for (int i = 0; i < count; i++)
-			{
-				auto pt = pts[*vtx_it];
-				poly.addVertex(pt);
-				vtx_it++;
-			}
-		}
+	std::vector<hio::Index> ElementRange::indices() const
+	{
+		if (!isContiguous())
+			return _indices;
 
+		std::vector<Index> arr(_count);
+		std::iota(arr.begin(), arr.end(), _start);
 		return arr;
-
 	}
-	
-	hio::BezierCurve Geometry::createBezierCurve(Size num_vertices, bool is_closed, int order)
+
+	std::vector<GA_Offset> ElementRange::offsets() const
 	{
-		GEO_PrimRBezCurve* curve = GU_PrimRBezCurve::build(&_geo, num_vertices, order, is_closed, true);
-		return BezierCurve(curve);
+		const GA_IndexMap& map = _geo->geo().getIndexMap(Enum2Enum(_type));
+
+		std::vector<GA_Offset> arr(_count);
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, _count), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+				arr[i] = map.offsetFromIndex(GA_Index(index(i)));
+		});
+		return arr;
 	}
 
-	hio::NURBSCurve Geometry::createNURBSCurve(Size num_vertices, bool is_closed, int order, int _interp_ends)
+	void PointRange::positions(Vector3* out_data) const
 	{
-		int interpEnds = is_closed ? 0 : 1;
-		if (_interp_ends >= 0)
-			interpEnds = _interp_ends;
+		attribValue<float>(Attrib(_geo->geo().getP()), (float*)out_data);
+	}
 
-		GEO_PrimNURBCurve* curve = GU_PrimNURBCurve::build(&_geo, num_vertices, order, is_closed, interpEnds, true);
-		return NURBSCurve(curve);
+	void PointRange::setPositions(const Vector3* in_data)
+	{
+		Attrib P(_geo->geo().getP());
+		setAttribValue<float>(P, (const float*)in_data);
 	}
 
-	void Geometry::deletePrims(const std::vector<Primitive>& prims, bool keep_points)
+	hio::Primitive PrimitiveRange::operator[](Size i) const
 	{
-		GA_PrimitiveGroup *grp = geo().newInternalPrimitiveGroup();
+		return _geo->prim(index(i));
+	}
 
-		for (auto prim : prims)
-			grp->addIndex(prim.number());
+	void PrimitiveRange::vertexCounts(Size* out_data) const
+	{
+		const GU_Detail& geo = _geo->geo();
+		const std::vector<GA_Offset> offs = offsets();
 
-		geo().deletePrimitives(*grp, !keep_points);
-		geo().destroyPrimitiveGroup(grp);
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, _count), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+				out_data[i] = geo.getPrimitiveVertexCount(offs[i]);
+		});
 	}
 
-	std::vector<Attrib> Geometry::pointAttribs() const
+	void PrimitiveRange::closedFlags(int* out_data) const
 	{
-		const auto& attrs = _geo.pointAttribs();
-		
-		std::vector<Attrib> arr;
+		const GU_Detail& geo = _geo->geo();
+		const std::vector<GA_Offset> offs = offsets();
 
-		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
-		while (it != attrs.end())
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, _count), [&](const UT_BlockedRange<Size>& r)
 		{
-			arr.push_back(*it);
-			it.operator++();
-		}
-
-		return arr;
+			for (Size i = r.begin(); i != r.end(); ++i)
+				out_data[i] = geo.getPrimitiveClosedFlag(offs[i]) ? 1 : 0;
+		});
 	}
 
-	std::vector<Attrib> Geometry::primAttribs() const
+	void PrimitiveRange::setClosedFlags(const int* in_data)
 	{
-		const auto& attrs = _geo.primitiveAttribs();
+		GU_Detail& geo = _geo->geo();
+		const std::vector<GA_Offset> offs = offsets();
 
-		std::vector<Attrib> arr;
-		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
-		while (it != attrs.end())
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, _count), [&](const UT_BlockedRange<Size>& r)
 		{
-			arr.push_back(*it);
-			it.operator++();
-		}
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				if (geo.getPrimitiveTypeId(offs[i]) == GA_PRIMPOLY)
+					static_cast<GEO_PrimPoly*>(geo.getGEOPrimitive(offs[i]))->setClosed(in_data[i] != 0);
+			}
+		});
+	}
 
-		return arr;
+	hio::Polygon Geometry::createPolygon(Size num_vertices, bool is_closed)
+	{
+		GEO_PrimPoly* poly = (GEO_PrimPoly*)GU_PrimPoly::build(&_geo, num_vertices, !is_closed, true);
+		return Polygon(poly);
 	}
 
-	std::vector<Attrib> Geometry::vertexAttribs() const
+
+	// Builds all polygons in one block. `vertices` are point numbers relative
+	// to `start_point`, returns the offset of the first new primitive.
+	static GA_Offset buildPolygonBlock(GU_Detail& geo, GA_Offset start_point, Size num_points,
+		Size vertices_size, const Index* vertices, Size vertex_counts_size, const Size* vertex_counts, bool closed)
 	{
-		const auto& attrs = _geo.vertexAttribs();
+		if (std::accumulate(vertex_counts, vertex_counts + vertex_counts_size, Size(0)) != vertices_size)
+			throw std::runtime_error("Vertex and vertex count mismatch");
 
-		std::vector<Attrib> arr;
-		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
-		while (it != attrs.end())
+		if (vertex_counts_size == 0)
+			return GA_INVALID_OFFSET;
+
+		GA_PolyCounts counts;
+		for (Size i = 0; i < vertex_counts_size; i++)
+			counts.append(vertex_counts[i]);
+
+		// buildBlock takes int point numbers
+		std::vector<int> point_numbers(vertices_size);
+		std::atomic<bool> in_range(true);
+
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, vertices_size), [&](const UT_BlockedRange<Size>& r)
 		{
-			arr.push_back(*it);
-			it.operator++();
-		}
+			bool ok = true;
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				ok &= vertices[i] >= 0 && vertices[i] < num_points;
+				point_numbers[i] = int(vertices[i]);
+			}
 
-		return arr;
+			if (!ok)
+				in_range = false;
+		});
+
+		if (!in_range)
+			throw std::runtime_error("Vertex index out of range");
+
+		return GEO_PrimPoly::buildBlock(&geo, start_point, num_points, counts, point_numbers.data(), closed);
 	}
 
-	std::vector<Attrib> Geometry::globalAttribs() const
+	hio::Index Geometry::createPolygonBlock(Size position_size, const Vector3* positions, Size vertices_size, const Index* vertices, Size vertex_counts_size, const Size* vertex_counts, bool closed)
 	{
-		const auto& attrs = _geo.attribs();
+		const Index first = getNumPrimitives();
 
-		std::vector<Attrib> arr;
-		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
-		while (it != attrs.end())
-		{
-			arr.push_back(*it);
-			it.operator++();
-		}
+		const GA_Offset start = _geo.appendPointBlock(position_size);
+		setTupleRange(_geo.getP(), start, position_size, (const float*)positions);
 
-		return arr;
+		buildPolygonBlock(_geo, start, position_size, vertices_size, vertices, vertex_counts_size, vertex_counts, closed);
+
+		return first;
 	}
 
-	hio::Attrib Geometry::findPointAttrib(const std::string& name) const
+	std::vector<hio::Polygon> Geometry::createPolygons(Size position_size, const Vector3* positions, Size vertex_counts_size, const Size* vertex_counts, bool closed)
 	{
-		return _geo.findPointAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+		if (std::accumulate(vertex_counts, vertex_counts + vertex_counts_size, Size(0)) != position_size)
+			throw std::runtime_error("Position and vertex count mismatch");
+
+		// one point per vertex, in order
+		std::vector<Index> vertices(position_size);
+		std::iota(vertices.begin(), vertices.end(), Index(0));
+
+		return createPolygons(position_size, positions, vertices.size(), vertices.data(), vertex_counts_size, vertex_counts, closed);
 	}
 
-	hio::Attrib Geometry::findPrimAttrib(const std::string& name) const
+	std::vector<hio::Polygon> Geometry::createPolygons(Size position_size, const Vector3* positions, Size vertices_size, const Index* vertices, Size vertex_counts_size, const Size* vertex_counts, bool closed)
 	{
-		return _geo.findPrimitiveAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
-	}
+		const Index first = createPolygonBlock(position_size, positions, vertices_size, vertices, vertex_counts_size, vertex_counts, closed);
 
-	hio::Attrib Geometry::findVertexAttrib(const std::string& name) const
+		std::vector<hio::Polygon> arr;
+		arr.reserve(vertex_counts_size);
+
+		for (Size i = 0; i < vertex_counts_size; i++)
+			arr.emplace_back(_geo.getGEOPrimitive(_geo.primitiveOffset(first + i)));
+
+		return arr;
+	}
+	
+	hio::Index Geometry::createPolylines(Size vertices_size, const Index* vertices, Size vertex_counts_size, const Size* vertex_counts)
 	{
-		return _geo.findVertexAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+		const Index first = getNumPrimitives();
+
+		// buildBlock binds point numbers relative to one contiguous block
+		if (!_geo.getPointMap().isTrivialMap())
+			_geo.defragment();
+
+		const GA_Offset start = getNumPoints() > 0 ? _geo.pointOffset(0) : GA_Offset(0);
+		buildPolygonBlock(_geo, start, getNumPoints(), vertices_size, vertices, vertex_counts_size, vertex_counts, false);
+
+		return first;
 	}
 
-	hio::Attrib Geometry::findGlobalAttrib(const std::string& name) const
+	hio::BezierCurve Geometry::createBezierCurve(Size num_vertices, bool is_closed, int order)
 	{
-		return _geo.findGlobalAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+		GEO_PrimRBezCurve* curve = GU_PrimRBezCurve::build(&_geo, num_vertices, order, is_closed, true);
+		return BezierCurve(curve);
 	}
-    
-	///
 
-    void Geometry::filterPrimitiveByType(std::vector<PrimitiveTypes> prim_types)
+	hio::NURBSCurve Geometry::createNURBSCurve(Size num_vertices, bool is_closed, int order, int _interp_ends)
 	{
-	    const auto& prims = this->prims();
-	    
-	    auto group = _geo.createDetachedPrimitiveGroup();
-
-	    for (const auto& prim : prims)
-	    {
-            auto it = std::find_if(prim_types.begin(), prim_types.end(), [&](PrimitiveTypes p)
-                { return prim.getTypeID() == (int)p; });
-	        
-	        if (it != prim_types.end())
-	        {
-	            group->add(prim.prim());
-	        }
-	    }
+		int interpEnds = is_closed ? 0 : 1;
+		if (_interp_ends >= 0)
+			interpEnds = _interp_ends;
 
-	    _geo.destroyPrimitives(GA_Range(*group, true), true);
+		GEO_PrimNURBCurve* curve = GU_PrimNURBCurve::build(&_geo, num_vertices, order, is_closed, interpEnds, true);
+		return NURBSCurve(curve);
 	}
 
-	bool Geometry::load(const std::string& path)
+	hio::Index Geometry::createCurves(PrimitiveTypes type, Size num_curves, const Size* counts, const int* orders, const int* closed,
+		Size positions_size, const Vector3* positions, const float* weights, const int* interp_ends)
 	{
-		GA_LoadOptions opts;
-		UT_StringArray errors;
+		if (type != PrimitiveTypes::NURBSCurve && type != PrimitiveTypes::BezierCurve)
+			throw std::runtime_error("Unsupported curve type");
 
-		std::string _path = path;
-		std::replace(_path.begin(), _path.end(), '\\', '/');
+		const bool bezier = type == PrimitiveTypes::BezierCurve;
 
-		auto res = _geo.load(_path.c_str(), &opts, &errors);
-		if (!res.success())
+		// input and output (curve point) starts of every curve
+		std::vector<Index> input_start(num_curves + 1, 0);
+		std::vector<Index> point_start(num_curves + 1, 0);
+
+		for (Size i = 0; i < num_curves; i++)
 		{
-			for (auto s : errors)
-				std::cerr << s << std::endl;
-			return false;
+			const Size n = counts[i];
+			if (n < 0)
+				throw std::runtime_error("Curve point count must be positive");
+
+			if (bezier && orders[i] != 4)
+				throw std::runtime_error("Bezier handles need order 4");
+
+			// curves with less than 2 points are skipped, they get no points
+			const Size num_curve_points = n < 2 ? 0 : (bezier ? (closed[i] ? n * 3 : n * 3 - 2) : n);
+
+			input_start[i + 1] = input_start[i] + (bezier ? n * 3 : n);
+			point_start[i + 1] = point_start[i] + num_curve_points;
 		}
 
-		return true;
-	}
+		if (input_start.back() != positions_size)
+			throw std::runtime_error("Position and count mismatch");
 
-	bool Geometry::save(const std::string& path)
-	{
-		UT_StringArray errors;
-		GA_SaveOptions opts;
+		const Index first = getNumPrimitives();
+		const Size num_points = point_start.back();
 
-		std::string _path = path;
-		std::replace(_path.begin(), _path.end(), '\\', '/');
+		if (num_curves == 0)
+			return first;
 
-		auto res = _geo.save(_path.c_str(), &opts, &errors);
-		if (!res.success())
+		// Points of all curves, Bezier anchors and handles in segment order:
+		// open:   a0 r0 l1 a1 r1 ... ln an
+		// closed: a0 r0 l1 a1 r1 ... an rn l0
+		std::vector<Vector3> points(num_points);
+		std::vector<float> point_weights(weights ? num_points : 0, 1.0f);
+
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, num_curves), [&](const UT_BlockedRange<Size>& r)
 		{
-			for (auto s : errors)
-				std::cerr << s << std::endl;
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				const Vector3* src = positions + input_start[i];
+				Vector3* dst = points.data() + point_start[i];
+
+				if (point_start[i + 1] == point_start[i])
+					continue;
+
+				if (!bezier)
+				{
+					std::copy(src, src + counts[i], dst);
+					if (weights)
+						std::copy(weights + input_start[i], weights + input_start[i + 1], point_weights.data() + point_start[i]);
+					continue;
+				}
+
+				const Size n = counts[i];
+				Size k = 0;
+				for (Size j = 0; j < n; j++)
+				{
+					if (j > 0)
+						dst[k++] = src[j * 3 + 0];
+
+					dst[k++] = src[j * 3 + 1];
+
+					if (j < n - 1 || closed[i])
+						dst[k++] = src[j * 3 + 2];
+				}
+
+				if (closed[i])
+					dst[k++] = src[0];
+			}
+		});
+
+		const GA_Offset start = _geo.appendPointBlock(num_points);
+		setTupleRange(_geo.getP(), start, num_points, (const float*)points.data());
+
+		if (weights)
+		{
+			Attrib Pw = findPointAttrib("Pw");
+			if (!Pw)
+				Pw = addAttrib<float>(AttribType::Point, "Pw", { 1 }, TypeInfo::Value);
+
+			Pw.setAttribValue<float>(point_weights.data(), start, num_points);
+		}
+
+		// There is no block builder for spline primitives, the curves are
+		// built one by one over the new points
+		for (Size i = 0; i < num_curves; i++)
+		{
+			const Size n = point_start[i + 1] - point_start[i];
+			if (n == 0)
+				continue;
+
+			// closed curves never interpolate their ends
+			const int interp = closed[i] ? 0 : (interp_ends ? interp_ends[i] != 0 : 1);
+
+			// Blender keeps e.g. order 4 on a 2 point spline, the HDK needs
+			// at least as many points as the order
+			const int order = SYSclamp(orders[i], 2, SYSmin((int)n, GA_MAXORDER));
+
+			GEO_Face* curve = bezier
+				? (GEO_Face*)GU_PrimRBezCurve::build(&_geo, n, 4, closed[i], false)
+				: (GEO_Face*)GU_PrimNURBCurve::build(&_geo, n, order, closed[i], interp, false);
+
+			if (!curve)
+				throw std::runtime_error("Curve could not be built");
+
+			for (Size v = 0; v < n; v++)
+				curve->setPointOffset(v, start + point_start[i] + v);
+		}
+
+		return first;
+	}
+
+	void Geometry::deletePrims(const std::vector<Primitive>& prims, bool keep_points)
+	{
+		GA_PrimitiveGroup *grp = geo().newInternalPrimitiveGroup();
+
+		for (auto prim : prims)
+			grp->addIndex(prim.number());
+
+		geo().deletePrimitives(*grp, !keep_points);
+		geo().destroyPrimitiveGroup(grp);
+		trackMemoryUsage();
+	}
+
+	Size Geometry::weldPoints(float tolerance, bool average)
+	{
+		GU_Detail& gdp = geo();
+
+		const Size n = gdp.getNumPoints();
+		if (n < 2 || tolerance < 0)
+			return 0;
+
+		std::vector<UT_Vector3> P(n);
+		UTparallelForLightItems(UT_BlockedRange<exint>(0, n), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+				P[i] = gdp.getPos3(gdp.pointOffset(GA_Index(i)));
+		});
+
+		// cells are as large as the tolerance, so every match is in one of the
+		// 27 cells around a point. Hash collisions only add candidates.
+		const float inv_cell = 1.0f / std::max(tolerance, 1e-6f);
+		const float tolerance2 = tolerance * tolerance;
+
+		auto cellOf = [&](const UT_Vector3& p, int axis) {
+			return (int64)std::floor(p[axis] * inv_cell);
+		};
+		auto hashCell = [](int64 x, int64 y, int64 z) {
+			return (uint64(x) * 73856093ULL) ^ (uint64(y) * 19349663ULL) ^ (uint64(z) * 83492791ULL);
+		};
+
+		using Entry = std::pair<uint64, Index>;
+		std::vector<Entry> entries(n);
+
+		UTparallelForLightItems(UT_BlockedRange<exint>(0, n), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+				entries[i] = { hashCell(cellOf(P[i], 0), cellOf(P[i], 1), cellOf(P[i], 2)), i };
+		});
+
+		UTparallelSort(entries.begin(), entries.end());
+
+		// lowest index neighbour within the tolerance, always below i or i itself
+		std::vector<Index> parent(n);
+
+		UTparallelFor(UT_BlockedRange<exint>(0, n), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const int64 cx = cellOf(P[i], 0), cy = cellOf(P[i], 1), cz = cellOf(P[i], 2);
+
+				Index best = i;
+				for (int64 x = cx - 1; x <= cx + 1; x++)
+				for (int64 y = cy - 1; y <= cy + 1; y++)
+				for (int64 z = cz - 1; z <= cz + 1; z++)
+				{
+					const uint64 h = hashCell(x, y, z);
+					auto it = std::lower_bound(entries.begin(), entries.end(), Entry(h, 0));
+
+					for (; it != entries.end() && it->first == h && it->second < best; ++it)
+					{
+						if ((P[it->second] - P[i]).length2() <= tolerance2)
+							best = it->second;
+					}
+				}
+
+				parent[i] = best;
+			}
+		});
+
+		// pointer jumping until every point refers to the root of its cluster
+		std::vector<Index> next(n);
+		std::atomic<bool> changed(true);
+
+		while (changed)
+		{
+			changed = false;
+
+			UTparallelForLightItems(UT_BlockedRange<exint>(0, n), [&](const UT_BlockedRange<exint>& r)
+			{
+				bool local = false;
+				for (exint i = r.begin(); i != r.end(); ++i)
+				{
+					next[i] = parent[parent[i]];
+					local |= next[i] != parent[i];
+				}
+				if (local)
+					changed = true;
+			});
+
+			parent.swap(next);
+		}
+
+		Size removed = 0;
+		for (Size i = 0; i < n; i++)
+		{
+			if (parent[i] != i)
+				removed++;
+		}
+
+		if (removed == 0)
+			return 0;
+
+		if (average)
+		{
+			std::vector<Size> counts(n, 0);
+			for (Size i = 0; i < n; i++)
+				counts[parent[i]]++;
+
+			for (Attrib attr : pointAttribs())
+			{
+				if (attr.dataType() != AttribData::Float)
+					continue;
+
+				const Size tuple_size = attr.tupleSize();
+
+				std::vector<float> values(n * tuple_size);
+				attr.attribValue<float>(values.data());
+
+				std::vector<double> sums(n * tuple_size, 0.0);
+				for (Size i = 0; i < n; i++)
+				{
+					for (Size k = 0; k < tuple_size; k++)
+						sums[parent[i] * tuple_size + k] += values[i * tuple_size + k];
+				}
+
+				UTparallelForLightItems(UT_BlockedRange<exint>(0, n), [&](const UT_BlockedRange<exint>& r)
+				{
+					for (exint i = r.begin(); i != r.end(); ++i)
+					{
+						if (parent[i] != i || counts[i] < 2)
+							continue;
+
+						for (Size k = 0; k < tuple_size; k++)
+							values[i * tuple_size + k] = float(sums[i * tuple_size + k] / counts[i]);
+					}
+				});
+
+				attr.setAttribValue<float>(values.data());
+			}
+		}
+
+		for (GA_Iterator it(gdp.getVertexRange()); !it.atEnd(); ++it)
+		{
+			const GA_Index pt = gdp.pointIndex(gdp.vertexPoint(*it));
+			if (parent[pt] != pt)
+				gdp.setVertexPoint(*it, gdp.pointOffset(GA_Index(parent[pt])));
+		}
+
+		// merged edges leave the same point twice in a row, drop those vertices
+		// and the polygons that collapse (closed below 3, open below 2 vertices)
+		GA_PrimitiveGroup* degenerate = gdp.newInternalPrimitiveGroup();
+
+		for (GA_Iterator it(gdp.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (gdp.getPrimitiveTypeId(*it) != GA_PRIMPOLY)
+				continue;
+
+			GEO_PrimPoly* poly = static_cast<GEO_PrimPoly*>(gdp.getGEOPrimitive(*it));
+			const bool closed = poly->isClosed();
+
+			for (GA_Size v = poly->getVertexCount() - 1; v >= 0; v--)
+			{
+				const GA_Size n = poly->getVertexCount();
+				if (v >= n || (!closed && v == n - 1))
+					continue;
+
+				const GA_Size next = (v + 1) % n;
+				if (next != v && poly->getPointOffset(v) == poly->getPointOffset(next))
+					poly->deleteVertex(v);
+			}
+
+			if (poly->getVertexCount() < (closed ? 3 : 2))
+				degenerate->add(poly);
+		}
+
+		gdp.deletePrimitives(*degenerate, false);
+		gdp.destroyPrimitiveGroup(degenerate);
+
+		GA_PointGroup* grp = gdp.newInternalPointGroup();
+
+		for (Size i = 0; i < n; i++)
+		{
+			if (parent[i] != i)
+				grp->addIndex(GA_Index(i));
+		}
+
+		gdp.deletePoints(*grp, GA_LEAVE_PRIMITIVES);
+		gdp.destroyPointGroup(grp);
+
+		// keep point offsets equal to indices
+		gdp.defragment();
+
+		trackMemoryUsage();
+		return removed;
+	}
+
+	// Spreads the low 21 bits of v so that two zero bits follow each bit
+	static uint64 spreadBits(uint64 v)
+	{
+		v &= 0x1fffff;
+		v = (v | (v << 32)) & 0x1f00000000ffffULL;
+		v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+		v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+		v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+		v = (v | (v << 2)) & 0x1249249249249249ULL;
+		return v;
+	}
+
+	void Geometry::reorderForLocality(std::vector<Index>& point_order, std::vector<Index>& prim_order)
+	{
+		GU_Detail& gdp = geo();
+
+		const Size num_points = gdp.getNumPoints();
+		const Size num_prims = gdp.getNumPrimitives();
+
+		UT_BoundingBox bbox;
+		gdp.getPointBBox(bbox);
+
+		const UT_Vector3 bmin = bbox.minvec();
+		const UT_Vector3 extent = bbox.size();
+
+		// 21 bits per axis, degenerate axes collapse to 0
+		const float levels = float((1 << 21) - 1);
+		UT_Vector3 scale;
+		for (int k = 0; k < 3; k++)
+			scale[k] = extent[k] > 0 ? levels / extent[k] : 0;
+
+		using Entry = std::pair<uint64, Index>;
+
+		std::vector<Entry> points(num_points);
+		UTparallelForLightItems(UT_BlockedRange<exint>(0, num_points), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const UT_Vector3 p = gdp.getPos3(gdp.pointOffset(GA_Index(i)));
+
+				uint64 code = 0;
+				for (int k = 0; k < 3; k++)
+				{
+					const float q = SYSclamp((p[k] - bmin[k]) * scale[k], 0.0f, levels);
+					code |= spreadBits(uint64(q)) << k;
+				}
+				points[i] = { code, i };
+			}
+		});
+
+		UTparallelSort(points.begin(), points.end());
+
+		point_order.resize(num_points);
+		std::vector<Index> point_rank(num_points);
+		UTparallelForLightItems(UT_BlockedRange<exint>(0, num_points), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				point_order[i] = points[i].second;
+				point_rank[points[i].second] = i;
+			}
+		});
+
+		// primitives without vertices go last
+		std::vector<Entry> prims(num_prims);
+		UTparallelForLightItems(UT_BlockedRange<exint>(0, num_prims), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const GA_Primitive* prim = gdp.getPrimitiveByIndex(GA_Index(i));
+
+				uint64 key = std::numeric_limits<uint64>::max();
+				if (prim->getVertexCount() > 0)
+					key = uint64(point_rank[gdp.pointIndex(prim->getPointOffset(0))]);
+
+				prims[i] = { key, i };
+			}
+		});
+
+		UTparallelSort(prims.begin(), prims.end());
+
+		prim_order.resize(num_prims);
+		for (Size i = 0; i < num_prims; i++)
+			prim_order[i] = prims[i].second;
+
+		GA_OffsetArray point_offsets(num_points, num_points);
+		for (Size i = 0; i < num_points; i++)
+			point_offsets(i) = gdp.pointOffset(GA_Index(point_order[i]));
+
+		GA_OffsetArray prim_offsets(num_prims, num_prims);
+		for (Size i = 0; i < num_prims; i++)
+			prim_offsets(i) = gdp.primitiveOffset(GA_Index(prim_order[i]));
+
+		gdp.sortPointList(point_offsets);
+		gdp.sortPrimitiveList(prim_offsets);
+
+		// move the data so that offsets follow the new indices again
+		gdp.defragment();
+		trackMemoryUsage();
+	}
+
+	std::vector<Attrib> Geometry::pointAttribs() const
+	{
+		const auto& attrs = _geo.pointAttribs();
+		
+		std::vector<Attrib> arr;
+
+		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
+		while (it != attrs.end())
+		{
+			arr.push_back(*it);
+			it.operator++();
+		}
+
+		return arr;
+	}
+
+	std::vector<Attrib> Geometry::primAttribs() const
+	{
+		const auto& attrs = _geo.primitiveAttribs();
+
+		std::vector<Attrib> arr;
+		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
+		while (it != attrs.end())
+		{
+			arr.push_back(*it);
+			it.operator++();
+		}
+
+		return arr;
+	}
+
+	std::vector<Attrib> Geometry::vertexAttribs() const
+	{
+		const auto& attrs = _geo.vertexAttribs();
+
+		std::vector<Attrib> arr;
+		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
+		while (it != attrs.end())
+		{
+			arr.push_back(*it);
+			it.operator++();
+		}
+
+		return arr;
+	}
+
+	std::vector<Attrib> Geometry::globalAttribs() const
+	{
+		const auto& attrs = _geo.attribs();
+
+		std::vector<Attrib> arr;
+		GA_AttributeDict::iterator it = attrs.begin(GA_SCOPE_PUBLIC);
+		while (it != attrs.end())
+		{
+			arr.push_back(*it);
+			it.operator++();
+		}
+
+		return arr;
+	}
+
+	MemoryUsage Geometry::memoryUsage() const
+	{
+		MemoryUsage out;
+
+		for (AttribType type : { AttribType::Point, AttribType::Vertex, AttribType::Prim, AttribType::Global })
+		{
+			for (const Attrib& attr : attribs(type))
+			{
+				out.attribs.push_back(attr.memoryUsage());
+				out.attrib_bytes += out.attribs.back().bytes;
+			}
+		}
+
+		const GA_Topology& topology = _geo.getTopology();
+		for (const GA_ATITopology* ref : { topology.getPointRef(), topology.getPrimitiveRef(),
+			topology.getVertexRef(), topology.getVertexPrevRef(), topology.getVertexNextRef() })
+		{
+			if (ref)
+				out.topology_bytes += ref->getMemoryUsage(true);
+		}
+
+		for (GA_AttributeOwner owner : { GA_ATTRIB_POINT, GA_ATTRIB_VERTEX, GA_ATTRIB_PRIMITIVE })
+			out.index_map_bytes += _geo.getIndexMap(owner).getMemoryUsage(true);
+
+		out.primitive_list_bytes = _geo.getPrimitiveList().getMemoryUsage(true);
+		out.total_bytes = _geo.getMemoryUsage(true);
+
+		const int64 listed = out.attrib_bytes + out.topology_bytes + out.index_map_bytes + out.primitive_list_bytes;
+		out.other_bytes = std::max<int64>(0, out.total_bytes - listed);
+
+		return out;
+	}
+
+	// Compares the stored values of two attributes with equal storage, tuple
+	// size and element count, numeric pages in parallel
+	static bool sameContent(const Attrib& a, const Attrib& b)
+	{
+		const Size num_elements = a.size();
+		const Size tuple_size = a.tupleSize();
+
+		if (a.dataType() == AttribData::String)
+		{
+			std::vector<std::string> table_a, table_b;
+			std::vector<int> indices_a(num_elements * tuple_size), indices_b(num_elements * tuple_size);
+			a.stringTable(table_a, indices_a.data());
+			b.stringTable(table_b, indices_b.data());
+			return table_a == table_b && indices_a == indices_b;
+		}
+
+		const Size num_pages = (num_elements + GA_PAGE_SIZE - 1) / GA_PAGE_SIZE;
+		std::atomic<bool> differs(false);
+
+		visitStorage(a.storage(), [&](auto tag)
+		{
+			using T = decltype(tag);
+
+			UTparallelForEachNumber((exint)num_pages, [&](const UT_BlockedRange<exint>& r)
+			{
+				std::vector<T> buffer_a, buffer_b;
+				for (exint page = r.begin(); page != r.end() && !differs.load(std::memory_order_relaxed); ++page)
+				{
+					const Index begin = page * GA_PAGE_SIZE;
+					const Size count = std::min<Size>(GA_PAGE_SIZE, num_elements - begin);
+
+					buffer_a.resize(count * tuple_size);
+					buffer_b.resize(count * tuple_size);
+					getTupleRange(a.attr(), begin, count, buffer_a.data());
+					getTupleRange(b.attr(), begin, count, buffer_b.data());
+
+					if (std::memcmp(buffer_a.data(), buffer_b.data(), buffer_a.size() * sizeof(T)) != 0)
+						differs = true;
+				}
+			});
+		});
+
+		return !differs;
+	}
+
+	std::vector<Attrib> Geometry::shareAttribs(const Geometry& other)
+	{
+		std::vector<std::pair<Attrib, Attrib>> candidates;
+
+		for (AttribType type : { AttribType::Point, AttribType::Vertex, AttribType::Prim, AttribType::Global })
+		{
+			if (elementCount(type) != other.elementCount(type))
+				continue;
+
+			for (const Attrib& attr : attribs(type))
+			{
+				Attrib src = other.findAttrib(type, attr.name());
+				if (!src || src.storage() != attr.storage() || src.tupleSize() != attr.tupleSize())
+					continue;
+
+				candidates.emplace_back(attr, src);
+			}
+		}
+
+		std::vector<char> equal(candidates.size(), 0);
+		UTparallelForEachNumber((exint)candidates.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+				equal[i] = sameContent(candidates[i].first, candidates[i].second);
+		});
+
+		std::vector<Attrib> shared;
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			if (!equal[i])
+				continue;
+
+			candidates[i].first.attr()->replace(*candidates[i].second.attr());
+			shared.push_back(candidates[i].first);
+		}
+
+		trackMemoryUsage();
+		return shared;
+	}
+
+	LiveMemoryUsage Geometry::liveMemoryUsage()
+	{
+		LiveMemoryUsage out;
+		out.geometries = live_geometries.load();
+		out.peak_geometries = peak_geometries.load();
+		out.total_bytes = live_bytes.load();
+		out.peak_bytes = peak_bytes.load();
+		return out;
+	}
+
+	std::vector<Attrib> Geometry::attribs(AttribType type) const
+	{
+		switch (type)
+		{
+			case AttribType::Point: return pointAttribs();
+			case AttribType::Prim: return primAttribs();
+			case AttribType::Vertex: return vertexAttribs();
+			case AttribType::Global: return globalAttribs();
+			default: throw std::runtime_error("Invalid enum");
+		}
+	}
+
+	hio::Attrib Geometry::findPointAttrib(const std::string& name) const
+	{
+		return _geo.findPointAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+	}
+
+	hio::Attrib Geometry::findPrimAttrib(const std::string& name) const
+	{
+		return _geo.findPrimitiveAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+	}
+
+	hio::Attrib Geometry::findVertexAttrib(const std::string& name) const
+	{
+		return _geo.findVertexAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+	}
+
+	hio::Attrib Geometry::findGlobalAttrib(const std::string& name) const
+	{
+		return _geo.findGlobalAttribute(GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+	}
+
+	hio::Attrib Geometry::findAttrib(AttribType type, const std::string& name) const
+	{
+		return _geo.findAttribute(Enum2Enum(type), GA_SCOPE_PUBLIC, UT_StringRef(name.c_str()));
+	}
+
+	void Geometry::cornerNormals(Vector3* out_data, bool flip) const
+	{
+		GA_ROHandleV3 vtx_N(_geo.findVertexAttribute(GA_SCOPE_PUBLIC, "N"));
+		GA_ROHandleV3 pt_N(_geo.findPointAttribute(GA_SCOPE_PUBLIC, "N"));
+
+		if (vtx_N.isInvalid() && pt_N.isInvalid())
+			throw std::runtime_error("N attribute not found");
+
+		const float sign = flip ? -1.0f : 1.0f;
+
+		UTparallelForLightItems(UT_BlockedRange<GA_Index>(0, getNumVertices()), [&](const UT_BlockedRange<GA_Index>& r)
+		{
+			for (GA_Index i = r.begin(); i != r.end(); ++i)
+			{
+				GA_Offset vtx = _geo.vertexOffset(i);
+				UT_Vector3 n = vtx_N.isValid() ? vtx_N.get(vtx) : pt_N.get(_geo.vertexPoint(vtx));
+
+				float len = n.length();
+				if (len > 0)
+					n *= sign / len;
+
+				out_data[i] = n;
+			}
+		});
+	}
+
+	void Geometry::curveData(CurveData& out) const
+	{
+		out = CurveData();
+
+		std::vector<const GEO_Curve*> curves;
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			int type_id = _geo.getPrimitiveTypeId(*it);
+			if (type_id == GA_PRIMNURBCURVE || type_id == GA_PRIMBEZCURVE)
+				curves.push_back((const GEO_Curve*)_geo.getGEOPrimitive(*it));
+		}
+
+		const Size num_curves = curves.size();
+
+		out.type.resize(num_curves);
+		out.order.resize(num_curves);
+		out.closed.resize(num_curves);
+		out.endpoint.resize(num_curves);
+		out.vertex_start.resize(num_curves + 1, 0);
+		out.knot_start.resize(num_curves + 1, 0);
+		out.anchor_start.resize(num_curves + 1, 0);
+
+		for (Size i = 0; i < num_curves; i++)
+		{
+			const GEO_Curve* curve = curves[i];
+			const int type_id = curve->getTypeId().get();
+			const Size num_vertices = curve->getVertexCount();
+			const int order = curve->getOrder();
+			const bool closed = curve->isClosed();
+
+			out.type[i] = (int)Enum2Enum(type_id, GA_PrimitiveTypeId_tag());
+			out.order[i] = order;
+			out.closed[i] = closed;
+			out.endpoint[i] = type_id == GA_PRIMNURBCURVE
+				? ((const GA_NUBBasis*)curve->getBasis())->getEndInterpolation()
+				: 1;
+
+			Size num_anchors = 0;
+			if (type_id == GA_PRIMBEZCURVE && num_vertices > 0)
+			{
+				const int step = SYSmax(order - 1, 1);
+				num_anchors = closed ? num_vertices / step : (num_vertices - 1) / step + 1;
+			}
+
+			out.vertex_start[i + 1] = out.vertex_start[i] + num_vertices;
+			out.knot_start[i + 1] = out.knot_start[i] + curve->getBasis()->getVector().entries();
+			out.anchor_start[i + 1] = out.anchor_start[i] + num_anchors;
+		}
+
+		out.positions.resize(out.vertex_start.back());
+		out.knots.resize(out.knot_start.back());
+		out.anchors.resize(out.anchor_start.back());
+		out.handle_left.resize(out.anchor_start.back());
+		out.handle_right.resize(out.anchor_start.back());
+
+		GA_ROHandleF Pw(_geo.findPointAttribute(GA_SCOPE_PUBLIC, "Pw"));
+
+		UTparallelFor(UT_BlockedRange<Size>(0, num_curves), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				const GEO_Curve* curve = curves[i];
+
+				const Index start = out.vertex_start[i];
+				const Size n = out.vertex_start[i + 1] - start;
+
+				for (Size v = 0; v < n; v++)
+				{
+					GA_Offset pt = curve->getPointOffset(v);
+					UT_Vector3 P = _geo.getPos3(pt);
+					out.positions[start + v] = Vector4(P.x(), P.y(), P.z(), Pw.isValid() ? Pw.get(pt) : 1.0f);
+				}
+
+				const GA_KnotVector& knots = curve->getBasis()->getVector();
+				for (Size k = 0; k < knots.entries(); k++)
+					out.knots[out.knot_start[i] + k] = knots(k);
+
+				// Bezier vertices are laid out as anchor, handle, ..., handle, anchor.
+				// Closed curves wrap around so the first anchor's left handle is the last vertex.
+				const Index anchor_start = out.anchor_start[i];
+				const Size num_anchors = out.anchor_start[i + 1] - anchor_start;
+				const int step = SYSmax(out.order[i] - 1, 1);
+				const Vector4* cv = out.positions.data() + start;
+
+				auto toVector3 = [](const Vector4& p) { return Vector3(p.x(), p.y(), p.z()); };
+
+				for (Size a = 0; a < num_anchors; a++)
+				{
+					const Index v = a * step;
+					const Index left = out.closed[i] ? (v + n - 1) % n : SYSmax(v - 1, Index(0));
+					const Index right = out.closed[i] ? (v + 1) % n : SYSmin(v + 1, n - 1);
+
+					out.anchors[anchor_start + a] = toVector3(cv[v]);
+					out.handle_left[anchor_start + a] = toVector3(cv[left]);
+					out.handle_right[anchor_start + a] = toVector3(cv[right]);
+				}
+			}
+		});
+	}
+
+	void Geometry::readAttribs(const std::vector<Attrib>& attribs, const std::vector<void*>& out_data) const
+	{
+		if (attribs.size() != out_data.size())
+			throw std::runtime_error("Attribute and buffer count mismatch");
+
+		for (const auto& attr : attribs)
+		{
+			if (attr.dataType() != AttribData::Float && attr.dataType() != AttribData::Int)
+				throw std::runtime_error("Storage type mismatch");
+		}
+
+		// Split every attribute into page aligned chunks so a few large
+		// attributes still spread over all threads
+		struct Task { size_t attrib; Index offset; Size size; };
+
+		const Size chunk_size = GA_PAGE_SIZE * 64;
+
+		std::vector<Task> tasks;
+		for (size_t i = 0; i < attribs.size(); i++)
+		{
+			const Size size = attribs[i].size();
+			for (Index offset = 0; offset < size; offset += chunk_size)
+				tasks.push_back({ i, offset, SYSmin(chunk_size, size - offset) });
+		}
+
+		UTparallelForEachNumber((exint)tasks.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const Task& task = tasks[i];
+				const Attrib& attr = attribs[task.attrib];
+				const Size tuple_size = attr.tupleSize();
+
+				if (attr.dataType() == AttribData::Float)
+				{
+					float* out = (float*)out_data[task.attrib] + task.offset * tuple_size;
+					attr.attribValue<float>(out, task.offset, task.size);
+				}
+				else
+				{
+					int* out = (int*)out_data[task.attrib] + task.offset * tuple_size;
+					attr.attribValue<int>(out, task.offset, task.size);
+				}
+			}
+		});
+	}
+
+	bool Geometry::isPointCloud() const
+	{
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMPART)
+				return false;
+		}
+
+		return true;
+	}
+
+	void Geometry::particlePoints(std::vector<Index>& out) const
+	{
+		out.clear();
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMPART)
+				continue;
+
+			const GA_OffsetListRef vtxs = _geo.getPrimitiveVertexList(*it);
+			for (GA_Size i = 0; i < vtxs.size(); i++)
+				out.push_back(_geo.pointIndex(_geo.vertexPoint(vtxs(i))));
+		}
+
+		if (out.empty())
+		{
+			out.resize(getNumPoints());
+			std::iota(out.begin(), out.end(), Index(0));
+		}
+	}
+
+	void Geometry::readPointAttribs(const std::vector<Attrib>& attribs, const std::vector<Index>& points, const std::vector<void*>& out_data) const
+	{
+		if (attribs.size() != out_data.size())
+			throw std::runtime_error("Attribute and buffer count mismatch");
+
+		for (const auto& attr : attribs)
+		{
+			if (attr.type() != AttribType::Point)
+				throw std::runtime_error("Not a point attribute: " + attr.name());
+
+			if (attr.dataType() != AttribData::Float && attr.dataType() != AttribData::Int)
+				throw std::runtime_error("Storage type mismatch");
+		}
+
+		// All points in order, the contiguous ranges are read directly
+		bool identity = (Size)points.size() == getNumPoints();
+		for (size_t i = 0; identity && i < points.size(); i++)
+			identity = points[i] == (Index)i;
+
+		if (identity)
+		{
+			readAttribs(attribs, out_data);
+			return;
+		}
+
+		std::vector<GA_Offset> offsets(points.size());
+		UTparallelForLightItems(UT_BlockedRange<size_t>(0, points.size()), [&](const UT_BlockedRange<size_t>& r)
+		{
+			for (size_t i = r.begin(); i != r.end(); ++i)
+				offsets[i] = _geo.pointOffset(points[i]);
+		});
+
+		const Size chunk_size = GA_PAGE_SIZE * 64;
+
+		struct Task { size_t attrib; Index offset; Size size; };
+
+		std::vector<Task> tasks;
+		for (size_t i = 0; i < attribs.size(); i++)
+		{
+			for (Index offset = 0; offset < (Size)points.size(); offset += chunk_size)
+				tasks.push_back({ i, offset, SYSmin(chunk_size, (Size)points.size() - offset) });
+		}
+
+		UTparallelForEachNumber((exint)tasks.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const Task& task = tasks[i];
+				const GA_Attribute* attr = attribs[task.attrib].attr();
+				const GA_AIFTuple* tuple = attr->getAIFTuple();
+				const int tuple_size = attr->getTupleSize();
+				const bool is_float = attribs[task.attrib].dataType() == AttribData::Float;
+
+				for (Index k = task.offset; k < task.offset + task.size; k++)
+				{
+					if (is_float)
+						tuple->get(attr, offsets[k], (float*)out_data[task.attrib] + k * tuple_size, tuple_size);
+					else
+						tuple->get(attr, offsets[k], (int*)out_data[task.attrib] + k * tuple_size, tuple_size);
+				}
+			}
+		});
+	}
+
+	hio::Size Geometry::elementCount(AttribType type) const
+	{
+		switch (type)
+		{
+			case AttribType::Point: return getNumPoints();
+			case AttribType::Prim: return getNumPrimitives();
+			case AttribType::Vertex: return getNumVertices();
+			case AttribType::Global: return 1;
+			default: throw std::runtime_error("Invalid enum");
+		}
+	}
+
+	void Geometry::promoteAttribValue(Attrib attr, AttribType dst_type, float* out_data, PromoteMethod method) const
+	{
+		const AttribType src_type = attr.type();
+
+		if (src_type == AttribType::Global || dst_type == AttribType::Global)
+			throw std::runtime_error("Global attributes can not be promoted");
+
+		if (attr.dataType() != AttribData::Float && attr.dataType() != AttribData::Int)
+			throw std::runtime_error("Storage type mismatch");
+
+		const Size tuple_size = attr.tupleSize();
+		const Size dst_size = elementCount(dst_type);
+
+		std::vector<float> src(attr.size() * tuple_size);
+		if (attr.dataType() == AttribData::Int)
+		{
+			std::vector<int> int_src(src.size());
+			attr.attribValue<int>(int_src.data(), 0, attr.size());
+			std::copy(int_src.begin(), int_src.end(), src.begin());
+		}
+		else
+		{
+			attr.attribValue<float>(src.data(), 0, attr.size());
+		}
+
+		if (src_type == dst_type)
+		{
+			std::copy(src.begin(), src.end(), out_data);
+			return;
+		}
+
+		// `src` is read by index, topology queries return offsets
+		auto src_index = [&](GA_Offset s) -> Index
+		{
+			switch (src_type)
+			{
+				case AttribType::Point: return _geo.pointIndex(s);
+				case AttribType::Vertex: return _geo.vertexIndex(s);
+				default: return _geo.primitiveIndex(s);
+			}
+		};
+
+		// Each destination element reduces the source elements it is connected to
+		auto reduce = [&](Index dst, const auto& for_each_src)
+		{
+			float* out = out_data + dst * tuple_size;
+			std::fill(out, out + tuple_size, 0.0f);
+
+			Size count = 0;
+			for_each_src([&](GA_Offset s)
+			{
+				if (method == PromoteMethod::First && count > 0)
+					return;
+
+				const float* in = src.data() + src_index(s) * tuple_size;
+				for (Size c = 0; c < tuple_size; c++)
+					out[c] += in[c];
+				count++;
+			});
+
+			if (count > 1)
+			{
+				for (Size c = 0; c < tuple_size; c++)
+					out[c] /= count;
+			}
+		};
+
+		auto for_each_point_vertex = [&](GA_Offset pt, const auto& f)
+		{
+			for (GA_Offset vtx = _geo.pointVertex(pt); GAisValid(vtx); vtx = _geo.vertexToNextVertex(vtx))
+				f(vtx);
+		};
+
+		UTparallelFor(UT_BlockedRange<Index>(0, dst_size), [&](const UT_BlockedRange<Index>& r)
+		{
+			for (Index i = r.begin(); i != r.end(); ++i)
+			{
+				if (dst_type == AttribType::Vertex)
+				{
+					const GA_Offset dst = _geo.vertexOffset(GA_Index(i));
+					GA_Offset s = src_type == AttribType::Point ? _geo.vertexPoint(dst) : _geo.vertexPrimitive(dst);
+					reduce(i, [&](const auto& f) { f(s); });
+				}
+				else if (dst_type == AttribType::Point)
+				{
+					const GA_Offset dst = _geo.pointOffset(GA_Index(i));
+					reduce(i, [&](const auto& f)
+					{
+						for_each_point_vertex(dst, [&](GA_Offset vtx)
+						{
+							f(src_type == AttribType::Vertex ? vtx : _geo.vertexPrimitive(vtx));
+						});
+					});
+				}
+				else
+				{
+					const GA_OffsetListRef vertices = _geo.getPrimitiveVertexList(_geo.primitiveOffset(GA_Index(i)));
+					reduce(i, [&](const auto& f)
+					{
+						for (GA_Size v = 0; v < vertices.size(); v++)
+							f(src_type == AttribType::Vertex ? vertices(v) : _geo.vertexPoint(vertices(v)));
+					});
+				}
+			}
+		});
+	}
+
+	hio::Attrib Geometry::promoteAttrib(Attrib attr, AttribType dst_type, const std::string& name, PromoteMethod method)
+	{
+		std::vector<float> data(elementCount(dst_type) * attr.tupleSize());
+		promoteAttribValue(attr, dst_type, data.data(), method);
+
+		if (attr.dataType() == AttribData::Float)
+		{
+			Attrib dst = addAttrib<float>(dst_type, name, std::vector<float>(attr.tupleSize(), 0.0f), attr.typeInfo());
+			dst.setAttribValue<float>(data.data(), 0, dst.size());
+			trackMemoryUsage();
+			return dst;
+		}
+
+		std::vector<int> int_data(data.size());
+		std::transform(data.begin(), data.end(), int_data.begin(), [](float v) { return (int)std::lround(v); });
+
+		Attrib dst = addAttrib<int>(dst_type, name, std::vector<int>(attr.tupleSize(), 0), attr.typeInfo());
+		dst.setAttribValue<int>(int_data.data(), 0, dst.size());
+		trackMemoryUsage();
+		return dst;
+	}
+
+	void Geometry::triangulate(Triangles& out) const
+	{
+		out = Triangles();
+
+		std::vector<GA_Offset> polys;
+		std::vector<Index> tri_start(1, 0);
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			const GA_Size num_vertices = _geo.getPrimitiveVertexCount(*it);
+
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMPOLY || !_geo.getPrimitiveClosedFlag(*it) || num_vertices < 3)
+				continue;
+
+			polys.push_back(*it);
+			tri_start.push_back(tri_start.back() + num_vertices - 2);
+		}
+
+		const Size num_tris = tri_start.back();
+		out.points.resize(num_tris * 3);
+		out.vertices.resize(num_tris * 3);
+		out.prims.resize(num_tris);
+
+		UTparallelFor(UT_BlockedRange<Size>(0, polys.size()), [&](const UT_BlockedRange<Size>& r)
+		{
+			std::vector<UT_Vector3> P;
+			std::vector<UT_Vector2> P2;
+			std::vector<int> tris;
+
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				const GA_OffsetListRef vertices = _geo.getPrimitiveVertexList(polys[i]);
+				const int n = (int)vertices.size();
+
+				P.resize(n);
+				for (int v = 0; v < n; v++)
+					P[v] = _geo.getPos3(_geo.vertexPoint(vertices(v)));
+
+				// Project onto the plane of the Newell normal's dominant axis
+				UT_Vector3 normal(0, 0, 0);
+				for (int v = 0; v < n; v++)
+				{
+					const UT_Vector3& a = P[v];
+					const UT_Vector3& b = P[(v + 1) % n];
+					normal += UT_Vector3((a.y() - b.y()) * (a.z() + b.z()),
+						(a.z() - b.z()) * (a.x() + b.x()),
+						(a.x() - b.x()) * (a.y() + b.y()));
+				}
+
+				const int axis = SYSabs(normal.x()) > SYSabs(normal.y())
+					? (SYSabs(normal.x()) > SYSabs(normal.z()) ? 0 : 2)
+					: (SYSabs(normal.y()) > SYSabs(normal.z()) ? 1 : 2);
+
+				P2.resize(n);
+				for (int v = 0; v < n; v++)
+					P2[v] = UT_Vector2(P[v]((axis + 1) % 3), P[v]((axis + 2) % 3));
+
+				bool convex = true;
+				float sign = 0;
+				for (int v = 0; v < n && convex; v++)
+				{
+					const UT_Vector2& a = P2[v];
+					const UT_Vector2& b = P2[(v + 1) % n];
+					const UT_Vector2& c = P2[(v + 2) % n];
+
+					const float cross = cross2(b - a, c - b);
+					if (cross == 0)
+						continue;
+
+					if (sign == 0)
+						sign = cross;
+					else if ((cross > 0) != (sign > 0))
+						convex = false;
+				}
+
+				tris.clear();
+
+				if (convex)
+				{
+					for (int v = 1; v + 1 < n; v++)
+						tris.insert(tris.end(), { 0, v, v + 1 });
+				}
+				else
+				{
+					earClip(P2, tris);
+				}
+
+				const Index start = tri_start[i];
+				for (size_t t = 0; t < tris.size(); t++)
+				{
+					const GA_Offset vtx = vertices(tris[t]);
+					out.vertices[start * 3 + t] = _geo.vertexIndex(vtx);
+					out.points[start * 3 + t] = _geo.pointIndex(_geo.vertexPoint(vtx));
+				}
+
+				const Index prim = _geo.primitiveIndex(polys[i]);
+				for (Size t = 0; t < tri_start[i + 1] - start; t++)
+					out.prims[start + t] = prim;
+			}
+		});
+	}
+
+	void Geometry::meshQuads(MeshQuads& out) const
+	{
+		out = MeshQuads();
+
+		std::vector<const GEO_PrimMesh*> meshes;
+		std::vector<Index> quad_start(1, 0);
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMMESH)
+				continue;
+
+			const GEO_PrimMesh* mesh = (const GEO_PrimMesh*)_geo.getGEOPrimitive(*it);
+			const int rows = mesh->getNumRows();
+			const int cols = mesh->getNumCols();
+
+			const Size quad_rows = rows < 2 ? 0 : rows - 1 + (mesh->isWrappedV() ? 1 : 0);
+			const Size quad_cols = cols < 2 ? 0 : cols - 1 + (mesh->isWrappedU() ? 1 : 0);
+
+			meshes.push_back(mesh);
+			quad_start.push_back(quad_start.back() + quad_rows * quad_cols);
+		}
+
+		const Size num_quads = quad_start.back();
+		out.points.resize(num_quads * 4);
+		out.vertices.resize(num_quads * 4);
+		out.prims.resize(num_quads);
+
+		UTparallelFor(UT_BlockedRange<Size>(0, meshes.size()), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				const GEO_PrimMesh* mesh = meshes[i];
+				const int rows = mesh->getNumRows();
+				const int cols = mesh->getNumCols();
+
+				const Size num = quad_start[i + 1] - quad_start[i];
+				if (num == 0)
+					continue;
+
+				const Size quad_cols = cols - 1 + (mesh->isWrappedU() ? 1 : 0);
+				const Index prim = _geo.primitiveIndex(mesh->getMapOffset());
+
+				// Quad (r, c) spans (r, c), (r, c + 1), (r + 1, c + 1), (r + 1, c)
+				UTparallelForLightItems(UT_BlockedRange<Size>(0, num), [&](const UT_BlockedRange<Size>& qr)
+				{
+					for (Size q = qr.begin(); q != qr.end(); ++q)
+					{
+						const int row = int(q / quad_cols);
+						const int col = int(q % quad_cols);
+						const int next_row = (row + 1) % rows;
+						const int next_col = (col + 1) % cols;
+
+						const GA_Offset corners[4] = {
+							mesh->getVertexOffset(row, col),
+							mesh->getVertexOffset(row, next_col),
+							mesh->getVertexOffset(next_row, next_col),
+							mesh->getVertexOffset(next_row, col),
+						};
+
+						const Index dst = quad_start[i] + q;
+						for (int c = 0; c < 4; c++)
+						{
+							out.vertices[dst * 4 + c] = _geo.vertexIndex(corners[c]);
+							out.points[dst * 4 + c] = _geo.pointIndex(_geo.vertexPoint(corners[c]));
+						}
+						out.prims[dst] = prim;
+					}
+				});
+			}
+		});
+	}
+
+	void Geometry::edges(Edges& out) const
+	{
+		out = Edges();
+		out.corner_edge.assign(getNumVertices(), -1);
+
+		struct EdgeEntry
+		{
+			Index a, b;
+			Index vertex;
+		};
+
+		std::vector<GA_Offset> polys;
+		std::vector<Index> entry_start(1, 0);
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMPOLY)
+				continue;
+
+			const Size n = _geo.getPrimitiveVertexCount(*it);
+			const Size segments = _geo.getPrimitiveClosedFlag(*it) ? n : std::max<Size>(n - 1, 0);
+
+			polys.push_back(*it);
+			entry_start.push_back(entry_start.back() + segments);
+		}
+
+		std::vector<EdgeEntry> entries(entry_start.back());
+
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, polys.size()), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				const GA_OffsetListRef vtxs = _geo.getPrimitiveVertexList(polys[i]);
+				const Size n = vtxs.size();
+				const Size segments = entry_start[i + 1] - entry_start[i];
+
+				for (Size k = 0; k < segments; k++)
+				{
+					const Index a = _geo.pointIndex(_geo.vertexPoint(vtxs(k)));
+					const Index b = _geo.pointIndex(_geo.vertexPoint(vtxs((k + 1) % n)));
+
+					EdgeEntry& e = entries[entry_start[i] + k];
+					e.a = std::min(a, b);
+					e.b = std::max(a, b);
+					e.vertex = _geo.vertexIndex(vtxs(k));
+				}
+			}
+		});
+
+		UTparallelSort(entries.begin(), entries.end(), [](const EdgeEntry& x, const EdgeEntry& y)
+		{
+			return x.a < y.a || (x.a == y.a && x.b < y.b);
+		});
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const EdgeEntry& e = entries[i];
+			if (i == 0 || e.a != entries[i - 1].a || e.b != entries[i - 1].b)
+			{
+				out.edges.push_back(e.a);
+				out.edges.push_back(e.b);
+			}
+
+			out.corner_edge[e.vertex] = Index(out.edges.size() / 2 - 1);
+		}
+	}
+
+	static inline int stridedRes(int res, int stride)
+	{
+		return (res + stride - 1) / stride;
+	}
+
+	void Geometry::volumeInfos(std::vector<VolumeInfo>& out, int stride) const
+	{
+		if (stride < 1)
+			throw std::runtime_error("Stride must be 1 or greater");
+
+		out.clear();
+
+		GA_ROHandleS name_h(_geo.findPrimitiveAttribute("name"));
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			if (_geo.getPrimitiveTypeId(*it) != GA_PRIMVOLUME)
+				continue;
+
+			const GEO_PrimVolume* vol = (const GEO_PrimVolume*)_geo.getGEOPrimitive(*it);
+
+			VolumeInfo info;
+			info.prim = _geo.primitiveIndex(*it);
+
+			if (name_h.isValid() && name_h.get(*it).isstring())
+				info.name = name_h.get(*it).toStdString();
+
+			int res[3];
+			vol->getRes(res[0], res[1], res[2]);
+			for (int i = 0; i < 3; i++)
+				info.resolution[i] = stridedRes(res[i], stride);
+
+			// Affine part of the index space, tapered volumes are approximated
+			UT_Vector3 o, x, y, z;
+			vol->indexToPos(0, 0, 0, o);
+			vol->indexToPos(stride, 0, 0, x);
+			vol->indexToPos(0, stride, 0, y);
+			vol->indexToPos(0, 0, stride, z);
+
+			info.transform = Matrix4(
+				x.x() - o.x(), x.y() - o.y(), x.z() - o.z(), 0,
+				y.x() - o.x(), y.y() - o.y(), y.z() - o.z(), 0,
+				z.x() - o.x(), z.y() - o.y(), z.z() - o.z(), 0,
+				o.x(), o.y(), o.z(), 1);
+
+			info.border = Enum2Enum(vol->getBorder());
+			info.border_value = (float)vol->getBorderValue();
+
+			out.push_back(info);
+		}
+	}
+
+	void Geometry::readVolumes(const std::vector<Index>& prims, const std::vector<float*>& out_data, int stride) const
+	{
+		if (stride < 1)
+			throw std::runtime_error("Stride must be 1 or greater");
+
+		if (prims.size() != out_data.size())
+			throw std::runtime_error("Primitive and buffer count mismatch");
+
+		std::vector<UT_VoxelArrayReadHandleF> handles;
+		for (Index prim : prims)
+		{
+			const GA_Offset off = _geo.primitiveOffset(prim);
+			if (_geo.getPrimitiveTypeId(off) != GA_PRIMVOLUME)
+				throw std::runtime_error("Not a volume primitive");
+
+			handles.push_back(((const GEO_PrimVolume*)_geo.getGEOPrimitive(off))->getVoxelHandle());
+		}
+
+		// One task per tile of every volume
+		struct Task { size_t volume; int tile; };
+
+		std::vector<Task> tasks;
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			for (int t = 0; t < handles[i]->numTiles(); t++)
+				tasks.push_back({ i, t });
+		}
+
+		UTparallelForEachNumber((exint)tasks.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				const Task& task = tasks[i];
+				const UT_VoxelArrayF& vox = *handles[task.volume];
+				const UT_VoxelTile<float>* tile = vox.getLinearTile(task.tile);
+
+				const int ny = stridedRes(vox.getYRes(), stride);
+				const int nz = stridedRes(vox.getZRes(), stride);
+				float* out = out_data[task.volume];
+
+				int tx, ty, tz;
+				vox.linearTileToXYZ(task.tile, tx, ty, tz);
+
+				const int x0 = tx * TILESIZE, y0 = ty * TILESIZE, z0 = tz * TILESIZE;
+
+				// first voxel of the tile on the stride grid
+				auto first = [&](int origin) { return (stride - origin % stride) % stride; };
+
+				for (int x = first(x0); x < tile->xres(); x += stride)
+				{
+					for (int y = first(y0); y < tile->yres(); y += stride)
+					{
+						for (int z = first(z0); z < tile->zres(); z += stride)
+						{
+							const Index dst = (Index((x0 + x) / stride) * ny + (y0 + y) / stride) * nz + (z0 + z) / stride;
+							out[dst] = (*tile)(x, y, z);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	static std::vector<const GA_ElementGroup*> findGroups(const GU_Detail& geo, AttribType type, const std::vector<std::string>& names)
+	{
+		if (type == AttribType::Global)
+			throw std::runtime_error("Invalid group type");
+
+		const GA_ElementGroupTable& table = geo.getElementGroupTable(Enum2Enum(type));
+
+		std::vector<const GA_ElementGroup*> groups;
+		for (const auto& name : names)
+		{
+			const GA_ElementGroup* group = static_cast<const GA_ElementGroup*>(table.find(name.c_str()));
+			if (!group)
+				throw std::runtime_error("Group not found: " + name);
+
+			groups.push_back(group);
+		}
+
+		return groups;
+	}
+
+	std::vector<std::string> Geometry::groupNames(AttribType type) const
+	{
+		if (type == AttribType::Global)
+			throw std::runtime_error("Invalid group type");
+
+		std::vector<std::string> names;
+
+		const GA_ElementGroupTable& table = _geo.getElementGroupTable(Enum2Enum(type));
+		for (auto it = table.beginTraverse(); !it.atEnd(); ++it)
+		{
+			const GA_Group* group = it.group();
+			if (!group->isInternal())
+				names.push_back(group->getName().toStdString());
+		}
+
+		return names;
+	}
+
+	void Geometry::groupMasks(AttribType type, const std::vector<std::string>& names, const std::vector<uint8_t*>& out_data) const
+	{
+		if (names.size() != out_data.size())
+			throw std::runtime_error("One output buffer per group expected");
+
+		const std::vector<const GA_ElementGroup*> groups = findGroups(_geo, type, names);
+		const GA_IndexMap& map = _geo.getIndexMap(Enum2Enum(type));
+		const Size num_bytes = (elementCount(type) + 7) / 8;
+
+		UTparallelForEachNumber((exint)groups.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				uint8_t* out = out_data[i];
+				std::fill(out, out + num_bytes, 0);
+
+				GA_Offset start, end;
+				for (GA_Iterator it(GA_Range(*groups[i])); it.blockAdvance(start, end); )
+				{
+					for (GA_Offset off = start; off < end; ++off)
+					{
+						const GA_Index index = map.indexFromOffset(off);
+						out[index >> 3] |= uint8_t(1u << (index & 7));
+					}
+				}
+			}
+		});
+	}
+
+	void Geometry::groupIndices(AttribType type, const std::vector<std::string>& names, std::vector<std::vector<Index>>& out) const
+	{
+		const std::vector<const GA_ElementGroup*> groups = findGroups(_geo, type, names);
+		const GA_IndexMap& map = _geo.getIndexMap(Enum2Enum(type));
+
+		out.clear();
+		out.resize(groups.size());
+
+		UTparallelForEachNumber((exint)groups.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				std::vector<Index>& indices = out[i];
+				indices.reserve(groups[i]->entries());
+
+				GA_Offset start, end;
+				for (GA_Iterator it(GA_Range(*groups[i])); it.blockAdvance(start, end); )
+				{
+					for (GA_Offset off = start; off < end; ++off)
+						indices.push_back(map.indexFromOffset(off));
+				}
+
+				// offsets only follow index order until the detail is reordered
+				if (!std::is_sorted(indices.begin(), indices.end()))
+					std::sort(indices.begin(), indices.end());
+			}
+		});
+	}
+
+	// Packed disk paths are relative to the .bgeo or start with $HIP, both
+	// resolve against the directory the detail was loaded from
+	static std::string resolvePackedPath(const std::string& path, const std::string& source_path)
+	{
+		std::string p = path;
+		std::replace(p.begin(), p.end(), '\\', '/');
+
+		const size_t slash = source_path.find_last_of('/');
+		const std::string base_dir = slash == std::string::npos ? std::string(".") : source_path.substr(0, slash);
+
+		for (const std::string var : { "$HIP/", "${HIP}/" })
+		{
+			if (p.compare(0, var.size(), var) == 0)
+				return base_dir + "/" + p.substr(var.size());
+		}
+
+		const bool absolute = !p.empty() && (p[0] == '/' || p.find(':') != std::string::npos);
+		if (absolute || source_path.empty())
+			return p;
+
+		return base_dir + "/" + p;
+	}
+
+	void Geometry::packedInstances(PackedInstances& out) const
+	{
+		out = PackedInstances();
+
+		// Packed geometry loaded from a file has one implementation per
+		// primitive, the packed details' unique ids tell the shared ones apart
+		std::map<std::string, Index> path_ids;
+		std::map<exint, Index> detail_ids;
+		std::vector<const GU_PackedImpl*> impls;
+		std::vector<GU_ConstDetailHandle> details;
+
+		for (GA_Iterator it(_geo.getPrimitiveRange()); !it.atEnd(); ++it)
+		{
+			const GA_Primitive* prim = _geo.getPrimitive(*it);
+			if (!GU_PrimPacked::isPackedPrimitive(*prim))
+				continue;
+
+			const GU_PrimPacked* packed = static_cast<const GU_PrimPacked*>(prim);
+			const GU_PackedImpl* impl = packed->implementation();
+
+			Index id = -1;
+
+			UT_StringHolder filename;
+			GA_LocalIntrinsic h = packed->findIntrinsic("filename");
+			if (h != GA_INVALID_INTRINSIC && packed->getIntrinsic(h, filename) && filename.isstring())
+			{
+				const std::string path = resolvePackedPath(filename.toStdString(), _source_path);
+
+				auto found = path_ids.find(path);
+				if (found == path_ids.end())
+				{
+					id = impls.size();
+					path_ids[path] = id;
+					impls.push_back(impl);
+					details.emplace_back();
+					out.paths.push_back(path);
+				}
+				else
+					id = found->second;
+			}
+			else
+			{
+				GU_ConstDetailHandle gdh = impl->getPackedDetail();
+
+				// without a detail there is nothing to share, every such primitive is its own prototype
+				auto found = gdh.isValid() ? detail_ids.find(gdh.gdp()->getUniqueId()) : detail_ids.end();
+				if (found == detail_ids.end())
+				{
+					id = impls.size();
+					if (gdh.isValid())
+						detail_ids[gdh.gdp()->getUniqueId()] = id;
+					impls.push_back(impl);
+					details.push_back(gdh);
+					out.paths.push_back(std::string());
+				}
+				else
+					id = found->second;
+			}
+
+			UT_Matrix4D xform;
+			packed->getFullTransform4(xform);
+
+			out.prims.push_back(_geo.primitiveIndex(*it));
+			out.transforms.push_back(Matrix4(xform));
+			out.prototype.push_back(id);
+		}
+
+		out.prototypes.resize(impls.size());
+
+		UTparallelForEachNumber((exint)impls.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint i = r.begin(); i != r.end(); ++i)
+			{
+				auto proto = std::make_shared<Geometry>();
+
+				// Files are read directly so they load concurrently, anything
+				// else goes through the packed implementation
+				if (out.paths[i].empty() || !proto->load(out.paths[i]))
+				{
+					GU_ConstDetailHandle gdh = details[i].isValid() ? details[i] : impls[i]->getPackedDetail();
+					if (gdh.isValid())
+						proto->_geo.replaceWith(*gdh.gdp());
+				}
+
+				out.prototypes[i] = proto;
+			}
+		});
+	}
+    
+	///
+
+    void Geometry::filterPrimitiveByType(std::vector<PrimitiveTypes> prim_types)
+	{
+	    const auto& prims = this->prims();
+	    
+	    auto group = _geo.createDetachedPrimitiveGroup();
+
+	    for (const auto& prim : prims)
+	    {
+            auto it = std::find_if(prim_types.begin(), prim_types.end(), [&](PrimitiveTypes p)
+                { return prim.getTypeID() == (int)p; });
+	        
+	        if (it != prim_types.end())
+	        {
+	            group->add(prim.prim());
+	        }
+	    }
+
+	    _geo.destroyPrimitives(GA_Range(*group, true), true);
+		trackMemoryUsage();
+	}
+
+	bool Geometry::load(const std::string& path)
+	{
+		GA_LoadOptions opts;
+		UT_StringArray errors;
+
+		std::string _path = path;
+		std::replace(_path.begin(), _path.end(), '\\', '/');
+
+		auto res = _geo.load(_path.c_str(), &opts, &errors);
+		if (!res.success())
+		{
+			for (auto s : errors)
+				std::cerr << s << std::endl;
+			return false;
+		}
+
+		_source_path = _path;
+
+		// a recycled detail drops its stashed leftovers
+		_geo.destroyStashed();
+
+		trackMemoryUsage();
+		return true;
+	}
+
+	void Geometry::setStoragePolicy(const std::string& name, AttribStorage storage, Size tuple_size)
+	{
+		_name_policies[name] = { storage, tuple_size };
+	}
+
+	void Geometry::setStoragePolicy(TypeInfo typeinfo, AttribStorage storage, Size tuple_size)
+	{
+		_typeinfo_policies[typeinfo] = { storage, tuple_size };
+	}
+
+	void Geometry::clearStoragePolicies()
+	{
+		_name_policies.clear();
+		_typeinfo_policies.clear();
+	}
+
+	// Converts every numeric attribute of `gdp` that has a policy. Name
+	// policies take precedence, P only follows a name policy. The detail's
+	// layout changes serially (a converted attribute is added next to the
+	// original), the values are then copied and converted in parallel over
+	// all pages of all converted attributes.
+	static void convertStorage(GU_Detail& gdp,
+		const std::map<std::string, StoragePolicy>& name_policies,
+		const std::map<TypeInfo, StoragePolicy>& typeinfo_policies)
+	{
+		struct Target
+		{
+			GA_AttributeOwner owner;
+			UT_StringHolder src_name;
+			const GA_Attribute* src;
+			GA_Attribute* dst;
+		};
+
+		std::vector<Target> targets;
+
+		for (GA_AttributeOwner owner : { GA_ATTRIB_POINT, GA_ATTRIB_VERTEX, GA_ATTRIB_PRIMITIVE, GA_ATTRIB_GLOBAL })
+		{
+			// renaming below changes the dictionary, so collect first
+			std::vector<GA_Attribute*> attrs;
+			for (GA_AttributeDict::iterator it = gdp.getAttributeDict(owner).begin(GA_SCOPE_PUBLIC); !it.atEnd(); ++it)
+				attrs.push_back(*it);
+
+			for (GA_Attribute* attr : attrs)
+			{
+				const GA_ATINumeric* numeric = GA_ATINumeric::cast(attr);
+				if (!numeric)
+					continue;
+
+				const std::string name = attr->getName().toStdString();
+				const StoragePolicy* policy = nullptr;
+
+				auto name_it = name_policies.find(name);
+				if (name_it != name_policies.end())
+					policy = &name_it->second;
+				else if (!(owner == GA_ATTRIB_POINT && name == "P"))
+				{
+					auto typeinfo_it = typeinfo_policies.find(Enum2Enum(attr->getTypeInfo()));
+					if (typeinfo_it != typeinfo_policies.end())
+						policy = &typeinfo_it->second;
+				}
+
+				if (!policy || GAgetStorageClass(Enum2Enum(policy->storage)) != attr->getStorageClass())
+					continue;
+
+				const GA_Storage storage = Enum2Enum(policy->storage);
+				const int tuple_size = policy->tuple_size > 0 ? (int)policy->tuple_size : attr->getTupleSize();
+
+				if (numeric->getStorage() == storage && attr->getTupleSize() == tuple_size)
+					continue;
+
+				const UT_StringHolder dst_name = attr->getName();
+				const UT_StringHolder src_name(name + "__hio_storage_policy");
+				const GA_Defaults defaults = numeric->getDefaults();
+				const GA_TypeInfo typeinfo = attr->getTypeInfo();
+
+				gdp.renameAttribute(owner, GA_SCOPE_PUBLIC, dst_name, src_name);
+
+				GA_Attribute* dst = gdp.addTuple(storage, owner, dst_name, tuple_size, defaults);
+				dst->setTypeInfo(typeinfo);
+				dst->hardenAllPages();
+
+				targets.push_back({ owner, src_name, attr, dst });
+			}
+		}
+
+		std::vector<std::pair<exint, GA_PageNum>> jobs;
+		for (exint i = 0; i < (exint)targets.size(); i++)
+		{
+			const GA_Size num_pages = (targets[i].dst->getIndexMap().offsetSize() + GA_PAGE_SIZE - 1) >> GA_PAGE_BITS;
+			for (GA_PageNum page = 0; page < num_pages; page++)
+				jobs.emplace_back(i, page);
+		}
+
+		// Every job writes one page of one converted attribute
+		UTparallelForEachNumber((exint)jobs.size(), [&](const UT_BlockedRange<exint>& r)
+		{
+			for (exint j = r.begin(); j != r.end(); ++j)
+			{
+				const Target& target = targets[jobs[j].first];
+
+				const GA_Offset start = GA_Offset(jobs[j].second << GA_PAGE_BITS);
+				const GA_Size count = SYSmin<GA_Size>(GA_PAGE_SIZE, target.dst->getIndexMap().offsetSize() - start);
+
+				const int src_tuple = target.src->getTupleSize();
+				const int dst_tuple = target.dst->getTupleSize();
+
+				auto convert = [&](auto tag)
+				{
+					using T = decltype(tag);
+
+					std::vector<T> src_values(count * src_tuple);
+					std::vector<T> dst_values(count * dst_tuple, T(0));
+					getTupleRange(target.src, start, count, src_values.data());
+
+					const int n = SYSmin(src_tuple, dst_tuple);
+					for (GA_Size e = 0; e < count; e++)
+						for (int c = 0; c < n; c++)
+							dst_values[e * dst_tuple + c] = src_values[e * src_tuple + c];
+
+					setTupleRange(target.dst, start, count, dst_values.data());
+				};
+
+				if (target.src->getStorageClass() == GA_STORECLASS_INT)
+					convert(int64());
+				else
+					convert(fpreal64());
+			}
+		});
+
+		for (const Target& target : targets)
+			gdp.destroyAttribute(target.owner, GA_SCOPE_PUBLIC, target.src_name);
+	}
+
+	void Geometry::applyStoragePolicies()
+	{
+		if (_name_policies.empty() && _typeinfo_policies.empty())
+			return;
+
+		convertStorage(_geo, _name_policies, _typeinfo_policies);
+
+		trackMemoryUsage();
+	}
+
+	bool Geometry::save(const std::string& path)
+	{
+		const GU_Detail* gdp = &_geo;
+
+		// Policies convert a copy, the caller's attributes keep their precision
+		GU_Detail converted;
+		if (!_name_policies.empty() || !_typeinfo_policies.empty())
+		{
+			converted.replaceWith(_geo);
+			convertStorage(converted, _name_policies, _typeinfo_policies);
+			gdp = &converted;
+		}
+
+		UT_StringArray errors;
+		GA_SaveOptions opts;
+
+		std::string _path = path;
+		std::replace(_path.begin(), _path.end(), '\\', '/');
+
+		auto res = gdp->save(_path.c_str(), &opts, &errors);
+		if (!res.success())
+		{
+			for (auto s : errors)
+				std::cerr << s << std::endl;
 			return false;
 		}
 
 		return true;
 	}
 
+	bool exportMesh(const std::string& path, const MeshArrays& arrays, const MeshExportOptions& options)
+	{
+		Geometry geo;
+
+		geo.createPolygonBlock(arrays.num_points, arrays.positions,
+			arrays.num_loops, arrays.loop_points,
+			arrays.num_faces, arrays.loop_totals, true);
+
+		for (const auto& layer : arrays.layers)
+		{
+			if (layer.size != geo.elementCount(layer.type))
+				throw std::runtime_error("Layer size mismatch: " + layer.name);
+
+			Attrib attr;
+			if (layer.data_type == AttribData::Float)
+				attr = geo.addAttrib<float>(layer.type, layer.name, std::vector<float>(layer.tuple_size, 0.0f), layer.typeinfo);
+			else if (layer.data_type == AttribData::Int)
+				attr = geo.addAttrib<int>(layer.type, layer.name, std::vector<int>(layer.tuple_size, 0), layer.typeinfo, layer.storage);
+			else
+				throw std::runtime_error("Storage type mismatch");
+
+			if (layer.storage == AttribStorage::Int64)
+				attr.setAttribValue<int64>(layer.data, 0, layer.size);
+			else if (layer.data_type == AttribData::Float)
+				attr.setAttribValue<float>(layer.data, 0, layer.size);
+			else
+				attr.setAttribValue<int>(layer.data, 0, layer.size);
+		}
+
+		for (const auto& layer : arrays.string_layers)
+		{
+			if (layer.size != geo.elementCount(layer.type))
+				throw std::runtime_error("Layer size mismatch: " + layer.name);
+
+			Attrib attr = geo.addAttrib<std::string>(layer.type, layer.name, { "" }, TypeInfo::Value);
+			attr.setStringTable(layer.table, layer.indices, 0, layer.size);
+		}
+
+		// after the layers, which only cover the faces
+		if (arrays.num_loose_edges > 0)
+		{
+			std::vector<Size> counts(arrays.num_loose_edges, 2);
+			geo.createPolylines(arrays.num_loose_edges * 2, arrays.loose_edges, counts.size(), counts.data());
+		}
+
+		if (options.weld_tolerance >= 0)
+			geo.weldPoints(options.weld_tolerance, options.weld_average);
+
+		if (options.reorder)
+		{
+			std::vector<Index> point_order, prim_order;
+			geo.reorderForLocality(point_order, prim_order);
+		}
+
+		for (const auto& it : options.typeinfo_policies)
+			geo.setStoragePolicy(it.first, it.second.storage, it.second.tuple_size);
+
+		return geo.save(path);
+	}
+
+	// Numeric conversion that goes through float for half precision values
+	template <typename T, typename S>
+	struct ValueCast { static T apply(S v) { return static_cast<T>(v); } };
+
+	template <typename T>
+	struct ValueCast<T, fpreal16> { static T apply(fpreal16 v) { return static_cast<T>(static_cast<fpreal32>(v)); } };
+
+	template <typename S>
+	struct ValueCast<fpreal16, S> { static fpreal16 apply(S v) { return fpreal16(static_cast<fpreal32>(v)); } };
+
+	template <>
+	struct ValueCast<fpreal16, fpreal16> { static fpreal16 apply(fpreal16 v) { return v; } };
+
+	void Attrib::setAttribValueStrided(const void* data, AttribStorage data_storage, Size rows, Size cols,
+		Index row_stride, Index col_stride, Index offset, fpreal64 fill)
+	{
+		if (dataType() != AttribData::Float && dataType() != AttribData::Int)
+			throw std::runtime_error("Storage type mismatch");
+
+		const Size tuple_size = tupleSize();
+		if (cols > tuple_size)
+			throw std::runtime_error("Tuple size mismatch");
+
+		if (offset < 0 || rows < 0 || offset + rows > size())
+			throw std::runtime_error("Range out of bounds");
+
+		if (rows == 0)
+			return;
+
+		GA_Attribute* A = _attr;
+
+		// chunks never share a page, the written pages are hardened up front
+		A->hardenAllPages(GA_Offset(offset), GA_Offset(offset + rows));
+
+		const Size pages_per_task = 16;
+		const Index first_page = offset / GA_PAGE_SIZE;
+		const Index last_page = (offset + rows - 1) / GA_PAGE_SIZE;
+		const Size num_tasks = (last_page - first_page) / pages_per_task + 1;
+
+		visitStorage(storage(), [&](auto dst_tag)
+		{
+			using T = decltype(dst_tag);
+
+			visitStorage(data_storage, [&](auto src_tag)
+			{
+				using S = decltype(src_tag);
+
+				const T fill_value = ValueCast<T, fpreal64>::apply(fill);
+
+				UTparallelForEachNumber((exint)num_tasks, [&](const UT_BlockedRange<exint>& r)
+				{
+					std::vector<T> buffer;
+
+					for (exint task = r.begin(); task != r.end(); ++task)
+					{
+						const Index page = first_page + task * pages_per_task;
+						const Index begin = SYSmax(Index(0), page * GA_PAGE_SIZE - offset);
+						const Index end = SYSmin(rows, (page + pages_per_task) * GA_PAGE_SIZE - offset);
+
+						buffer.resize((end - begin) * tuple_size);
+
+						for (Index row = begin; row < end; row++)
+						{
+							const char* src = (const char*)data + row * row_stride;
+							T* dst = buffer.data() + (row - begin) * tuple_size;
+
+							for (Size c = 0; c < cols; c++)
+								dst[c] = ValueCast<T, S>::apply(*(const S*)(src + c * col_stride));
+
+							for (Size c = cols; c < tuple_size; c++)
+								dst[c] = fill_value;
+						}
+
+						setTupleRange(A, offset + begin, end - begin, buffer.data());
+					}
+				});
+			});
+		});
+	}
+
+	void Attrib::setStorage(AttribStorage storage)
+	{
+		GA_ATINumeric* numeric = GA_ATINumeric::cast(_attr);
+
+		if (!numeric || GAgetStorageClass(Enum2Enum(storage)) != _attr->getStorageClass())
+			throw std::runtime_error("Storage type mismatch");
+
+		numeric->setStorage(Enum2Enum(storage));
+	}
+
+	AttribMemory Attrib::memoryUsage() const
+	{
+		AttribMemory out;
+		out.name = name();
+		out.type = type();
+		out.storage = storage();
+		out.tuple_size = tupleSize();
+		out.bytes = _attr->getMemoryUsage(true);
+
+		if (const GA_ATINumeric* numeric = GA_ATINumeric::cast(_attr))
+		{
+			const GA_Offset num_offsets = _attr->getIndexMap().offsetSize();
+			out.pages = (num_offsets + GA_PAGE_SIZE - 1) >> GA_PAGE_BITS;
+
+			for (GA_PageNum page = 0; page < out.pages; page++)
+			{
+				if (numeric->getData().isPageConstant(page))
+					out.constant_pages++;
+			}
+		}
+		else if (const GA_AIFSharedStringTuple* strings = _attr->getAIFSharedStringTuple())
+		{
+			out.strings = strings->getTableEntries(_attr);
+		}
+
+		return out;
+	}
+
+	void Attrib::setTupleSize(Size tuple_size)
+	{
+		GA_ATINumeric* numeric = GA_ATINumeric::cast(_attr);
+
+		if (!numeric)
+			throw std::runtime_error("Storage type mismatch");
+
+		if (tuple_size <= 0)
+			throw std::runtime_error("Tuple size must be positive");
+
+		numeric->setTupleSize(tuple_size);
+	}
+
+	void Attrib::stringTable(std::vector<std::string>& table, int* out_indices, Index offset, Size size) const
+	{
+		if (offset == 0 && size == -1)
+			size = this->size() - offset;
+
+		auto A = _attr;
+
+		if (A->getStorageClass() != GA_STORECLASS_STRING)
+			throw std::runtime_error("Storage type mismatch");
+
+		if (offset < 0 || size < 0)
+			throw std::runtime_error("Bound must be positive");
+
+		if (offset > this->size() || offset + size > this->size())
+			throw std::runtime_error("Array index out of bounds");
+
+		const GA_AIFSharedStringTuple* tuple = A->getAIFSharedStringTuple();
+
+		UT_StringArray strings;
+		UT_IntArray handles;
+		tuple->extractStrings(A, strings, handles);
+
+		// Handles may have holes, remap them to a compact table
+		exint max_handle = -1;
+		for (exint i = 0; i < handles.entries(); i++)
+			max_handle = SYSmax(max_handle, (exint)handles(i));
+
+		std::vector<int> remap(max_handle + 1, -1);
+
+		table.resize(strings.entries());
+		for (exint i = 0; i < strings.entries(); i++)
+		{
+			table[i] = strings(i).toStdString();
+			remap[handles(i)] = (int)i;
+		}
+
+		const int tuple_size = A->getTupleSize();
+
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, size), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+			{
+				for (int c = 0; c < tuple_size; c++)
+				{
+					exint handle = tuple->getHandle(A, GA_Offset(offset + i), c);
+					out_indices[i * tuple_size + c] = (handle >= 0 && handle <= max_handle) ? remap[handle] : -1;
+				}
+			}
+		});
+	}
+
+	void Attrib::setStringTable(const std::vector<std::string>& table, const int* in_indices, Index offset, Size size)
+	{
+		if (offset == 0 && size == -1)
+			size = this->size() - offset;
+
+		auto A = _attr;
+
+		if (A->getStorageClass() != GA_STORECLASS_STRING)
+			throw std::runtime_error("Storage type mismatch");
+
+		if (offset < 0 || size < 0)
+			throw std::runtime_error("Bound must be positive");
+
+		if (offset > this->size() || offset + size > this->size())
+			throw std::runtime_error("Array index out of bounds");
+
+		const int tuple_size = A->getTupleSize();
+		const Size N = size * tuple_size;
+
+		for (Size i = 0; i < N; i++)
+		{
+			if (in_indices[i] < -1 || in_indices[i] >= (int)table.size())
+				throw std::runtime_error("String table index out of bounds");
+		}
+
+		const GA_AIFSharedStringTuple* tuple = A->getAIFSharedStringTuple();
+
+		UT_StringArray strings;
+		for (const auto& s : table)
+			strings.append(UT_StringHolder(s));
+
+		UT_Array<GA_StringIndexType> handles;
+		tuple->addStrings(A, strings, handles);
+
+		// Handles are reference counted by the string table, so this stays serial
+		for (Size i = 0; i < size; i++)
+		{
+			for (int c = 0; c < tuple_size; c++)
+			{
+				int index = in_indices[i * tuple_size + c];
+				tuple->setHandle(A, GA_Offset(offset + i), index < 0 ? GA_INVALID_STRING_INDEX : handles(index), c);
+			}
+		}
+	}
+
 	void Primitive::setPositions(const Vector3* data, Index offset, Size size)
 	{
 		Attrib P(prim()->getDetail().getP());
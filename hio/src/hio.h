@@ -5,12 +5,16 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
+#include <mutex>
+#include <algorithm>
 #include <iostream>
 
 ///
 
 #include <UT/UT_IStream.h>
 #include <UT/UT_OStream.h>
+#include <UT/UT_ParallelUtil.h>
 
 #include <GA/GA_SaveOptions.h>
 #include <GA/GA_LoadOptions.h>
@@ -25,6 +29,17 @@
 #include <GEO/GEO_PrimNURBCurve.h>
 #include <GEO/GEO_PrimRBezCurve.h>
 #include <GEO/GEO_PrimPart.h>
+#include <GEO/GEO_Curve.h>
+#include <GEO/GEO_PrimMesh.h>
+#include <GEO/GEO_PrimVolume.h>
+
+#include <GU/GU_PrimPacked.h>
+#include <GU/GU_PackedImpl.h>
+
+#include <GA/GA_NUBBasis.h>
+#include <GA/GA_PolyCounts.h>
+#include <GA/GA_AIFSharedStringTuple.h>
+#include <GA/GA_ATINumeric.h>
 
 #include <GU/GU_PrimPoly.h>
 #include <GU/GU_PrimNURBCurve.h>
@@ -59,6 +74,7 @@ namespace hio {
 	using Vector2 = UT_Vector2T<float>;
 	using Vector3 = UT_Vector3T<float>;
 	using Vector4 = UT_Vector4T<float>;
+	using Matrix4 = UT_Matrix4T<float>;
 
 	enum class AttribType
 	{
@@ -75,6 +91,31 @@ namespace hio {
 		Invalid
 	};
 
+	enum class AttribStorage {
+		UInt8,
+		Int8,
+		Int16,
+		Int32,
+		Int64,
+		Real16,
+		Real32,
+		Real64,
+		String,
+		Invalid
+	};
+
+	enum class PromoteMethod {
+		Average,
+		First
+	};
+
+	enum class VolumeBorder {
+		Constant,
+		Repeat,
+		Streak,
+		SDF
+	};
+
 	enum class TypeInfo {
 		Point,
 		Vector,
@@ -104,6 +145,7 @@ namespace hio {
 			case hio::PrimitiveTypes::Poly: return GA_PRIMPOLY;
 			case hio::PrimitiveTypes::NURBSCurve: return GA_PRIMNURBCURVE;
 			case hio::PrimitiveTypes::BezierCurve: return GA_PRIMBEZCURVE;
+			case hio::PrimitiveTypes::Mesh: return GA_PRIMMESH;
 			default: return GA_PRIMNONE;
 		}
 	}
@@ -114,6 +156,7 @@ namespace hio {
 			case GA_PRIMPOLY: return hio::PrimitiveTypes::Poly;
 			case GA_PRIMNURBCURVE: return hio::PrimitiveTypes::NURBSCurve;
 			case GA_PRIMBEZCURVE: return hio::PrimitiveTypes::BezierCurve;
+			case GA_PRIMMESH: return hio::PrimitiveTypes::Mesh;
 			default: return hio::PrimitiveTypes::None;
 		}
 	}
@@ -138,6 +181,49 @@ namespace hio {
 		}
 	}
 
+	inline GA_Storage Enum2Enum(AttribStorage v) {
+		switch (v)
+		{
+			case hio::AttribStorage::UInt8: return GA_STORE_UINT8;
+			case hio::AttribStorage::Int8: return GA_STORE_INT8;
+			case hio::AttribStorage::Int16: return GA_STORE_INT16;
+			case hio::AttribStorage::Int32: return GA_STORE_INT32;
+			case hio::AttribStorage::Int64: return GA_STORE_INT64;
+			case hio::AttribStorage::Real16: return GA_STORE_REAL16;
+			case hio::AttribStorage::Real32: return GA_STORE_REAL32;
+			case hio::AttribStorage::Real64: return GA_STORE_REAL64;
+			case hio::AttribStorage::String: return GA_STORE_STRING;
+			default: return GA_STORE_INVALID;
+		}
+	}
+
+	inline AttribStorage Enum2Enum(GA_Storage v) {
+		switch (v)
+		{
+			case GA_STORE_UINT8: return hio::AttribStorage::UInt8;
+			case GA_STORE_INT8: return hio::AttribStorage::Int8;
+			case GA_STORE_INT16: return hio::AttribStorage::Int16;
+			case GA_STORE_INT32: return hio::AttribStorage::Int32;
+			case GA_STORE_INT64: return hio::AttribStorage::Int64;
+			case GA_STORE_REAL16: return hio::AttribStorage::Real16;
+			case GA_STORE_REAL32: return hio::AttribStorage::Real32;
+			case GA_STORE_REAL64: return hio::AttribStorage::Real64;
+			case GA_STORE_STRING: return hio::AttribStorage::String;
+			default: return hio::AttribStorage::Invalid;
+		}
+	}
+
+	inline VolumeBorder Enum2Enum(GEO_VolumeBorder v) {
+		switch (v)
+		{
+			case GEO_VOLUMEBORDER_CONSTANT: return hio::VolumeBorder::Constant;
+			case GEO_VOLUMEBORDER_REPEAT: return hio::VolumeBorder::Repeat;
+			case GEO_VOLUMEBORDER_STREAK: return hio::VolumeBorder::Streak;
+			case GEO_VOLUMEBORDER_SDF: return hio::VolumeBorder::SDF;
+			default: return hio::VolumeBorder::Constant;
+		}
+	}
+
 	inline GA_AttributeOwner Enum2Enum(AttribType v) {
 		switch (v)
 		{
@@ -214,7 +300,156 @@ namespace hio {
 		static constexpr GA_StorageClass value = GA_STORECLASS_STRING;
 	};
 
+	template <> struct Type2Enum<uint8, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_INT;
+	};
+
+	template <> struct Type2Enum<int8, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_INT;
+	};
+
+	template <> struct Type2Enum<int16, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_INT;
+	};
+
+	template <> struct Type2Enum<int64, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_INT;
+	};
+
+	template <> struct Type2Enum<fpreal16, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_FLOAT;
+	};
+
+	template <> struct Type2Enum<fpreal64, GA_StorageClass> {
+		static constexpr GA_StorageClass value = GA_STORECLASS_FLOAT;
+	};
+
+	template <> struct Type2Enum<uint8, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_UINT8;
+	};
+
+	template <> struct Type2Enum<int8, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_INT8;
+	};
+
+	template <> struct Type2Enum<int16, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_INT16;
+	};
+
+	template <> struct Type2Enum<int32, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_INT32;
+	};
+
+	template <> struct Type2Enum<int64, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_INT64;
+	};
+
+	template <> struct Type2Enum<fpreal16, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_REAL16;
+	};
+
+	template <> struct Type2Enum<fpreal32, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_REAL32;
+	};
+
+	template <> struct Type2Enum<fpreal64, GA_Storage> {
+		static constexpr GA_Storage value = GA_STORE_REAL64;
+	};
+
 	//////////////////////////////////////////////////////////////////////////
+
+	// GA_AIFTuple covers 32 and 64 bit storage, narrower types are copied
+	// straight from the numeric page array so no conversion pass is needed.
+
+	template <typename T>
+	inline void getTupleRange(const GA_Attribute* A, Index offset, Size size, T* out_data)
+	{
+		GA_ATINumeric::cast(A)->getData().getRange(GA_Offset(offset), GA_Offset(size), out_data);
+	}
+
+	template <typename T>
+	inline void setTupleRange(GA_Attribute* A, Index offset, Size size, const T* in_data)
+	{
+		GA_ATINumeric::cast(A)->getData().setRange(GA_Offset(offset), GA_Offset(size), in_data);
+	}
+
+#define HIO_AIFTUPLE_RANGE(T) \
+	inline void getTupleRange(const GA_Attribute* A, Index offset, Size size, T* out_data) \
+	{ \
+		GA_Range range(A->getIndexMap(), GA_Offset(offset), GA_Offset(offset + size)); \
+		A->getAIFTuple()->getRange(A, range, out_data, 0, A->getTupleSize()); \
+	} \
+	inline void setTupleRange(GA_Attribute* A, Index offset, Size size, const T* in_data) \
+	{ \
+		GA_Range range(A->getIndexMap(), GA_Offset(offset), GA_Offset(offset + size)); \
+		A->getAIFTuple()->setRange(A, range, in_data, 0, A->getTupleSize()); \
+	}
+
+	HIO_AIFTUPLE_RANGE(int32)
+	HIO_AIFTUPLE_RANGE(int64)
+	HIO_AIFTUPLE_RANGE(fpreal32)
+	HIO_AIFTUPLE_RANGE(fpreal64)
+
+#undef HIO_AIFTUPLE_RANGE
+
+	// Hardens only the pages holding `offsets` before they are written
+	// concurrently, constant pages elsewhere stay shared
+	inline void hardenPages(GA_Attribute* A, const GA_Offset* offsets, Size count)
+	{
+		std::vector<GA_PageNum> pages(count);
+		UTparallelForLightItems(UT_BlockedRange<Size>(0, count), [&](const UT_BlockedRange<Size>& r)
+		{
+			for (Size i = r.begin(); i != r.end(); ++i)
+				pages[i] = GAgetPageNum(offsets[i]);
+		});
+
+		UTparallelSort(pages.begin(), pages.end());
+		pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+		const GA_Offset end = A->getIndexMap().offsetSize();
+		for (GA_PageNum page : pages)
+		{
+			const GA_Offset page_start = GA_Offset(page << GA_PAGE_BITS);
+			A->hardenAllPages(page_start, SYSmin(page_start + GA_Offset(GA_PAGE_SIZE), end));
+		}
+	}
+
+	// Calls `f` with a value of the C++ type matching a numeric storage
+	template <typename F>
+	inline void visitStorage(AttribStorage storage, F&& f)
+	{
+		switch (storage)
+		{
+			case AttribStorage::UInt8: f(uint8()); break;
+			case AttribStorage::Int8: f(int8()); break;
+			case AttribStorage::Int16: f(int16()); break;
+			case AttribStorage::Int32: f(int32()); break;
+			case AttribStorage::Int64: f(int64()); break;
+			case AttribStorage::Real16: f(fpreal16()); break;
+			case AttribStorage::Real32: f(fpreal32()); break;
+			case AttribStorage::Real64: f(fpreal64()); break;
+			default: throw std::runtime_error("Storage type mismatch");
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Bytes held by one attribute. Numeric attributes count their pages, a
+	// constant page stores a single tuple for a whole page of elements.
+	struct AttribMemory
+	{
+		std::string name;
+		AttribType type;
+		AttribStorage storage;
+		Size tuple_size;
+
+		int64 bytes = 0;
+		Size pages = 0;
+		Size constant_pages = 0;
+
+		// unique strings of string attributes
+		Size strings = 0;
+	};
 	
 	class Attrib
 	{
@@ -242,6 +477,13 @@ namespace hio {
 		std::string name() const { return _attr->getName().toStdString(); }
 		AttribType type() const { return Enum2Enum(_attr->getOwner()); }
 		AttribData dataType() const { return Enum2Enum(_attr->getStorageClass()); }
+		AttribStorage storage() const {
+			if (dataType() == AttribData::String)
+				return AttribStorage::String;
+
+			const GA_AIFTuple* tuple = _attr->getAIFTuple();
+			return tuple ? Enum2Enum(tuple->getStorage(_attr)) : AttribStorage::Invalid;
+		}
 		TypeInfo typeInfo() const { return Enum2Enum(_attr->getTypeInfo()); }
 
 		Size tupleSize() const { return _attr->getTupleSize(); }
@@ -273,13 +515,7 @@ namespace hio {
 			if (offset > this->size() || offset + size > this->size())
 				throw std::runtime_error("Array index out of bounds");
 
-			const GA_AIFTuple* tuple = A->getAIFTuple();
-			GA_Range range(A->getIndexMap(), GA_Offset(offset), GA_Offset(offset + size));
-
-			int tuple_size = tuple->getTupleSize(A);
-			int N = tuple_size * size;
-
-			tuple->getRange(A, range, (T*)out_data, 0, tuple_size);
+			getTupleRange(A, offset, size, (T*)out_data);
 		}
 
 		template <>
@@ -330,13 +566,7 @@ namespace hio {
 			if (offset > this->size() || offset + size > this->size())
 				throw std::runtime_error("Array index out of bounds");
 
-			const GA_AIFTuple* tuple = A->getAIFTuple();
-			GA_Range range(A->getIndexMap(), GA_Offset(offset), GA_Offset(offset + size));
-
-			int tuple_size = tuple->getTupleSize(A);
-			int N = tuple_size * size;
-
-			tuple->setRange(A, range, (const T*)in_data, 0, tuple_size);
+			setTupleRange(A, offset, size, (const T*)in_data);
 		}
 
 		template <>
@@ -369,8 +599,130 @@ namespace hio {
 
 		//////////////////////////////////////////////////////////////////////////
 
+		// Tuples of the elements at `indices`, one tuple per index. Indices are
+		// bounds checked once, the copy runs in parallel.
+		template <typename T>
+		void gatherValue(const Index* indices, Size count, T* out_data) const
+		{
+			const GA_Attribute* A = _attr;
+			const std::vector<GA_Offset> offsets = indexOffsets<T>(indices, count);
+
+			const GA_AIFTuple* tuple = A->getAIFTuple();
+			const int tuple_size = A->getTupleSize();
+
+			UTparallelForLightItems(UT_BlockedRange<Size>(0, count), [&](const UT_BlockedRange<Size>& r)
+			{
+				for (Size i = r.begin(); i != r.end(); ++i)
+					tuple->get(A, offsets[i], out_data + i * tuple_size, tuple_size);
+			});
+		}
+
+		// Writes one tuple per index. Indices must be unique: duplicates are
+		// written concurrently, which is undefined behavior.
+		template <typename T>
+		void scatterValue(const Index* indices, Size count, const T* in_data)
+		{
+			GA_Attribute* A = _attr;
+			const std::vector<GA_Offset> offsets = indexOffsets<T>(indices, count);
+
+			const GA_AIFTuple* tuple = A->getAIFTuple();
+			const int tuple_size = A->getTupleSize();
+
+			hardenPages(A, offsets.data(), count);
+
+			UTparallelForLightItems(UT_BlockedRange<Size>(0, count), [&](const UT_BlockedRange<Size>& r)
+			{
+				for (Size i = r.begin(); i != r.end(); ++i)
+					tuple->set(A, offsets[i], in_data + i * tuple_size, tuple_size);
+			});
+		}
+
+		// Like setAttribValue(), but only elements with a non zero `mask` entry
+		// are written. `mask` and `in_data` both cover [offset, offset + size).
+		template <typename T>
+		void setAttribValueMasked(const uint8_t* mask, const T* in_data, Index offset = 0, Size size = -1)
+		{
+			if (size < 0)
+				size = this->size() - offset;
+
+			if (offset < 0 || offset + size > this->size())
+				throw std::runtime_error("Array index out of bounds");
+
+			std::vector<Index> indices;
+			for (Size i = 0; i < size; i++)
+			{
+				if (mask[i])
+					indices.push_back(offset + i);
+			}
+
+			std::vector<T> values(indices.size() * tupleSize());
+			const Size tuple_size = tupleSize();
+
+			UTparallelForLightItems(UT_BlockedRange<size_t>(0, indices.size()), [&](const UT_BlockedRange<size_t>& r)
+			{
+				for (size_t i = r.begin(); i != r.end(); ++i)
+					std::copy_n(in_data + (indices[i] - offset) * tuple_size, tuple_size, values.data() + i * tuple_size);
+			});
+
+			scatterValue<T>(indices.data(), indices.size(), values.data());
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Converts the stored precision / tuple size in place (numeric attributes only)
+		void setStorage(AttribStorage storage);
+		void setTupleSize(Size tuple_size);
+
+		AttribMemory memoryUsage() const;
+
+		// Writes `rows` tuples from a strided source of any numeric storage,
+		// converting to the attribute's storage in parallel page sized chunks.
+		// Strides are in bytes, components past `cols` are set to `fill`.
+		void setAttribValueStrided(const void* data, AttribStorage data_storage, Size rows, Size cols,
+			Index row_stride, Index col_stride, Index offset = 0, fpreal64 fill = 0);
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Shared string table plus one table index per element and tuple component.
+		// Empty strings are stored as index -1.
+		void stringTable(std::vector<std::string>& table, int* out_indices, Index offset = 0, Size size = -1) const;
+		void setStringTable(const std::vector<std::string>& table, const int* in_indices, Index offset = 0, Size size = -1);
+
+		//////////////////////////////////////////////////////////////////////////
+
 		GA_Attribute* attr() const { return _attr; }
 
+	private:
+
+		// Storage and bounds checks shared by gather and scatter. int64 storage
+		// needs int64 values, int32 would silently truncate.
+		template <typename T>
+		std::vector<GA_Offset> indexOffsets(const Index* indices, Size count) const
+		{
+			if (Type2Enum<T, GA_StorageClass>::value != _attr->getStorageClass())
+				throw std::runtime_error("Storage type mismatch");
+
+			if (sizeof(T) < sizeof(int64) && storage() == AttribStorage::Int64)
+				throw std::runtime_error("Storage type mismatch");
+
+			if (count > 0)
+			{
+				auto bounds = std::minmax_element(indices, indices + count);
+				if (*bounds.first < 0 || *bounds.second >= size())
+					throw std::runtime_error("Array index out of bounds");
+			}
+
+			const GA_IndexMap& map = _attr->getIndexMap();
+
+			std::vector<GA_Offset> offsets(count);
+			UTparallelForLightItems(UT_BlockedRange<Size>(0, count), [&](const UT_BlockedRange<Size>& r)
+			{
+				for (Size i = r.begin(); i != r.end(); ++i)
+					offsets[i] = map.offsetFromIndex(GA_Index(indices[i]));
+			});
+			return offsets;
+		}
+
 	protected:
 
 		GA_Attribute* _attr;
@@ -640,13 +992,228 @@ namespace hio {
 
 	//////////////////////////////////////////////////////////////////////////
 
+	// Elements of one class as `start` + `count`, or as an index array. Bulk
+	// operations work on the whole range, element objects are only created
+	// by operator[].
+	// Ranges hold element indices of the Geometry they came from. Deleting,
+	// welding, reordering or filtering elements invalidates them.
+	class ElementRange
+	{
+	public:
+
+		ElementRange(Geometry* geo, AttribType type, Index start, Size count)
+			: _geo(geo), _type(type), _contiguous(true), _start(start), _count(count) {}
+
+		ElementRange(Geometry* geo, AttribType type, std::vector<Index> indices)
+			: _geo(geo), _type(type), _contiguous(false), _start(0), _count(indices.size()), _indices(std::move(indices)) {}
+
+		AttribType type() const { return _type; }
+		Size size() const { return _count; }
+
+		bool isContiguous() const { return _contiguous; }
+		Index start() const { return _start; }
+
+		Index index(Size i) const { return isContiguous() ? _start + i : _indices[i]; }
+		std::vector<Index> indices() const;
+
+		// Offsets of every element in range order
+		std::vector<GA_Offset> offsets() const;
+
+		// size() * tupleSize() values of `attr`, which must belong to type()
+		template <typename T>
+		void attribValue(const Attrib& attr, T* out_data) const;
+
+		template <typename T>
+		void setAttribValue(Attrib& attr, const T* in_data);
+
+	protected:
+
+		Geometry* _geo;
+		AttribType _type;
+		bool _contiguous;
+		Index _start;
+		Size _count;
+		std::vector<Index> _indices;
+	};
+
+	class PointRange : public ElementRange
+	{
+	public:
+
+		PointRange(Geometry* geo, Index start, Size count)
+			: ElementRange(geo, AttribType::Point, start, count) {}
+
+		PointRange(Geometry* geo, std::vector<Index> indices)
+			: ElementRange(geo, AttribType::Point, std::move(indices)) {}
+
+		Point operator[](Size i) const { return Point(index(i)); }
+
+		void positions(Vector3* out_data) const;
+		void setPositions(const Vector3* in_data);
+	};
+
+	class PrimitiveRange : public ElementRange
+	{
+	public:
+
+		PrimitiveRange(Geometry* geo, Index start, Size count)
+			: ElementRange(geo, AttribType::Prim, start, count) {}
+
+		PrimitiveRange(Geometry* geo, std::vector<Index> indices)
+			: ElementRange(geo, AttribType::Prim, std::move(indices)) {}
+
+		Primitive operator[](Size i) const;
+
+		void vertexCounts(Size* out_data) const;
+		void closedFlags(int* out_data) const;
+
+		// Polygons only, other primitive types are left unchanged
+		void setClosedFlags(const int* in_data);
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Storage conversion applied when saving, tuple_size < 0 keeps the tuple size
+	struct StoragePolicy
+	{
+		AttribStorage storage;
+		Size tuple_size;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// All NURBS and Bezier curves of a detail in primitive order. Per-curve
+	// ranges are CSR offsets, i.e. curve `i` owns [start[i], start[i + 1]).
+	struct CurveData
+	{
+		std::vector<int> type;
+		std::vector<int> order;
+		std::vector<int> closed;
+		std::vector<int> endpoint;
+
+		std::vector<Index> vertex_start;
+		std::vector<Vector4> positions; // (x, y, z, Pw)
+
+		std::vector<Index> knot_start;
+		std::vector<float> knots;
+
+		// De-interleaved Bezier anchors, empty range for NURBS curves
+		std::vector<Index> anchor_start;
+		std::vector<Vector3> anchors;
+		std::vector<Vector3> handle_left;
+		std::vector<Vector3> handle_right;
+	};
+
+	// Triangulation of closed polygons, three entries per triangle in
+	// `points` and `vertices`, one source primitive per triangle in `prims`
+	struct Triangles
+	{
+		std::vector<Index> points;
+		std::vector<Index> vertices;
+		std::vector<Index> prims;
+	};
+
+	// Quads of all mesh (grid) primitives, four corners per quad in
+	// `points` and `vertices`, one source primitive per quad in `prims`
+	struct MeshQuads
+	{
+		std::vector<Index> points;
+		std::vector<Index> vertices;
+		std::vector<Index> prims;
+	};
+
+	// Unique undirected polygon edges as point index pairs (smaller index
+	// first). corner_edge holds, per vertex, the edge to the next vertex of
+	// its polygon, -1 for the last vertex of an open polygon.
+	struct Edges
+	{
+		std::vector<Index> edges;
+		std::vector<Index> corner_edge;
+	};
+
+	// Volume primitive header. `resolution` and `transform` (voxel index to
+	// world, row vectors) already account for the stride used to read it.
+	struct VolumeInfo
+	{
+		Index prim;
+		std::string name;
+		int resolution[3];
+		Matrix4 transform;
+		VolumeBorder border;
+		float border_value;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Byte breakdown of a detail, `other` covers whatever the detail holds
+	// beyond the listed parts (groups, primitive data, ...)
+	struct MemoryUsage
+	{
+		std::vector<AttribMemory> attribs;
+
+		int64 attrib_bytes = 0;
+		int64 topology_bytes = 0;
+		int64 index_map_bytes = 0;
+		int64 primitive_list_bytes = 0;
+		int64 other_bytes = 0;
+		int64 total_bytes = 0;
+	};
+
+	// Process wide totals over every live Geometry. Both are sampled, not
+	// exact: each Geometry measures its own size at the end of load, clear,
+	// recycle, copyFrom, deletePrims, weldPoints, reorderForLocality,
+	// filterPrimitiveByType, promoteAttrib and applyStoragePolicies, and the
+	// peak is the largest total at any sample. The create* builders don't
+	// sample, to keep the walk off their hot path, so their growth (and any
+	// write through Attrib handles) only shows up at the next sampled call.
+	struct LiveMemoryUsage
+	{
+		Size geometries = 0;
+		Size peak_geometries = 0;
+		int64 total_bytes = 0;
+		int64 peak_bytes = 0;
+	};
+
+	// Packed primitives as an instance table. Every instance refers to one of
+	// the unique `prototypes`, packed disk primitives sharing a file and packed
+	// geometry sharing a detail are loaded once.
+	struct PackedInstances
+	{
+		std::vector<Index> prims;
+		std::vector<Matrix4> transforms;
+		std::vector<Index> prototype;
+
+		// source file per prototype (relative and $HIP paths resolved against
+		// the loaded .bgeo's directory), empty for in-memory packed geometry
+		std::vector<std::string> paths;
+		std::vector<std::shared_ptr<Geometry>> prototypes;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
 	class Geometry
 	{
 	public:
 
 		Geometry();
+		~Geometry();
+
+		Geometry(const Geometry&) = delete;
+		Geometry& operator=(const Geometry&) = delete;
 
 		void clear();
+
+		// Empties the detail by stashing its points and primitives
+		// (GA_Detail::stashAll()). load() destroys whatever is still stashed.
+		void recycle();
+
+		// Copy with attribute pages shared until either side writes them,
+		// storage policies included
+		std::shared_ptr<Geometry> clone() const;
+
+		// Replaces the contents, storage policies and source path with
+		// `other`'s, e.g. to restore a snapshot into a pooled detail
+		void copyFrom(const Geometry& other);
 	    void reverse();
 
 		Size getNumPoints() const;
@@ -663,6 +1230,15 @@ namespace hio {
 		Primitive prim(Index index) const;
 		std::vector<Primitive> prims() const;
 
+		// count < 0 runs to the last element. Ranges can write to this
+		// Geometry, so they are only handed out by non-const methods.
+		PointRange pointRange(Index start = 0, Size count = -1);
+		PointRange pointSelection(const std::vector<Index>& indices);
+		PrimitiveRange primRange(Index start = 0, Size count = -1);
+		PrimitiveRange primSelection(const std::vector<Index>& indices);
+
+		PointRange createPointRange(Size size, const Vector3* data);
+
 		Polygon createPolygon(Size num_vertices = 0, bool is_closed = true);
 
 		std::vector<Polygon> createPolygons(Size position_size, const Vector3* positions,
@@ -673,23 +1249,68 @@ namespace hio {
 			Size vertex_counts_size, const Size* vertex_counts,
 			bool closed = true);
 
+		// Creates the points and all polygons in one block allocation. Returns
+		// the index of the first new primitive.
+		Index createPolygonBlock(Size position_size, const Vector3* positions,
+			Size vertices_size, const Index* vertices,
+			Size vertex_counts_size, const Size* vertex_counts,
+			bool closed = true);
+
+		// Open polygons over existing points, built in one block. Returns the
+		// index of the first new primitive. A detail whose points have holes
+		// is defragmented first, so point offsets can move.
+		Index createPolylines(Size vertices_size, const Index* vertices,
+			Size vertex_counts_size, const Size* vertex_counts);
+
 		BezierCurve createBezierCurve(Size num_vertices, bool is_closed = false, int order = 4);
 		NURBSCurve createNURBSCurve(Size num_vertices, bool is_closed = false, int order = 4, int _interp_ends = -1);
 
+		// Creates `num_curves` curves of one type with all their points in one
+		// block. NURBS curves take `counts[i]` control points each, open curves
+		// interpolate their ends unless `interp_ends[i]` (optional) is 0,
+		// `weights` (optional) are written to `Pw`.
+		// Bezier curves take (handle_left, anchor, handle_right) triplets for
+		// `counts[i]` anchors each, the handles are interleaved into cubic
+		// segments. NURBS orders are clamped to [2, min(points, GA_MAXORDER)].
+		// Curves with less than 2 points are skipped (their input is still
+		// consumed), so the new primitives only line up with the input curves
+		// when none is skipped. Returns the index of the first new primitive.
+		Index createCurves(PrimitiveTypes type, Size num_curves, const Size* counts, const int* orders, const int* closed,
+			Size positions_size, const Vector3* positions, const float* weights = nullptr, const int* interp_ends = nullptr);
+
 		void deletePrims(const std::vector<Primitive>& prims, bool keep_points = false);
 
+		// Merges points within `tolerance` of each other through a spatial hash.
+		// Merges chain, every cluster keeps its lowest index point and vertices
+		// are rewired to it. With `average`, float point attributes (P included)
+		// become the cluster mean; int and string point attributes keep the
+		// root point's value. Repeated consecutive points are removed from
+		// polygons, polygons left with less than 3 (open: 2) vertices are
+		// deleted. Returns the number of removed points.
+		Size weldPoints(float tolerance, bool average = false);
+
+		// Sorts points along a Morton curve over their bounding box and
+		// primitives by their (new) first point, ties keep the old order. The
+		// detail is defragmented, so all attributes and topology are permuted.
+		// `point_order[i]` / `prim_order[i]` is the old index of new element i.
+		void reorderForLocality(std::vector<Index>& point_order, std::vector<Index>& prim_order);
+
 		std::vector<Attrib> pointAttribs() const;
 		std::vector<Attrib> primAttribs() const;
 		std::vector<Attrib> vertexAttribs() const;
 		std::vector<Attrib> globalAttribs() const;
+		std::vector<Attrib> attribs(AttribType type) const;
 	    
+		// `storage` selects the precision, Invalid means 32 bit float/int
 		template <typename T>
-		Attrib_<T> addAttrib(AttribType type, const std::string& name, const std::vector<T>& default_value, TypeInfo typeinfo);
+		Attrib_<T> addAttrib(AttribType type, const std::string& name, const std::vector<T>& default_value, TypeInfo typeinfo,
+			AttribStorage storage = AttribStorage::Invalid);
 
 		Attrib findPointAttrib(const std::string& name) const;
 		Attrib findPrimAttrib(const std::string& name) const;
 		Attrib findVertexAttrib(const std::string& name) const;
 		Attrib findGlobalAttrib(const std::string& name) const;
+		Attrib findAttrib(AttribType type, const std::string& name) const;
 
 		template <typename T>
 		std::vector<T> attribValue(const std::string& name);
@@ -697,6 +1318,99 @@ namespace hio {
 		template <typename T>
 		std::vector<T> attribValue(Attrib attr);
 
+		// Per-corner unit normals indexed by vertex number. Vertex `N` is used
+		// when present, otherwise point `N` is promoted to the corners.
+		void cornerNormals(Vector3* out_data, bool flip = false) const;
+
+		void curveData(CurveData& out) const;
+
+		// Reads float and int attributes concurrently into float32/int32 buffers
+		// of size() * tupleSize() elements, one buffer per attribute.
+		void readAttribs(const std::vector<Attrib>& attribs, const std::vector<void*>& out_data) const;
+
+		// True when the detail has no primitives other than particle systems
+		bool isPointCloud() const;
+
+		// Points of all particle primitives in primitive order, or every point
+		// when the detail has no particle primitives
+		void particlePoints(std::vector<Index>& out) const;
+
+		// readAttribs() restricted to point attributes of the given points,
+		// each buffer holds points.size() * tupleSize() elements
+		void readPointAttribs(const std::vector<Attrib>& attribs, const std::vector<Index>& points, const std::vector<void*>& out_data) const;
+
+		// Converts attribute values to another element class (point, vertex or prim).
+		// out_data holds float32 values for every element of `dst_type`, int sources
+		// are converted to float. Going to a coarser class either averages the
+		// contributing elements or takes the first.
+		void promoteAttribValue(Attrib attr, AttribType dst_type, float* out_data, PromoteMethod method = PromoteMethod::Average) const;
+		Attrib promoteAttrib(Attrib attr, AttribType dst_type, const std::string& name, PromoteMethod method = PromoteMethod::Average);
+
+		Size elementCount(AttribType type) const;
+
+		// Fan triangulates convex polygons and ear clips concave ones
+		void triangulate(Triangles& out) const;
+
+		// Splits mesh primitives into quads, wrapped rows/columns close the grid
+		void meshQuads(MeshQuads& out) const;
+
+		// Edges of polygon primitives, open polygons contribute their segments only
+		void edges(Edges& out) const;
+
+		// Every volume primitive, `name` comes from the prim `name` attribute.
+		// A stride above 1 keeps every stride-th voxel along each axis.
+		void volumeInfos(std::vector<VolumeInfo>& out, int stride = 1) const;
+
+		// Dense voxels of the given volume primitives, x major (index x * ny * nz
+		// + y * nz + z). Tiles are decompressed in parallel.
+		void readVolumes(const std::vector<Index>& prims, const std::vector<float*>& out_data, int stride = 1) const;
+
+		// Transforms are the full packed transforms (row vectors, translation in
+		// the last row). Prototypes are loaded in parallel and may contain
+		// packed primitives themselves.
+		void packedInstances(PackedInstances& out) const;
+
+		///
+
+		// Names of the point, prim or vertex groups, internal groups are skipped
+		std::vector<std::string> groupNames(AttribType type) const;
+
+		// One bit per element, element i is bit (i % 8) of byte (i / 8). Every
+		// buffer holds (elementCount(type) + 7) / 8 bytes. Groups are read in parallel.
+		void groupMasks(AttribType type, const std::vector<std::string>& names, const std::vector<uint8_t*>& out_data) const;
+
+		// Sorted element indices per group. Groups are read in parallel.
+		void groupIndices(AttribType type, const std::vector<std::string>& names, std::vector<std::vector<Index>>& out) const;
+
+		///
+
+		// Policies are applied by save() to a copy of the detail, this one
+		// keeps its storage. Name policies take precedence over TypeInfo
+		// policies, P is only converted by a name policy and attributes of
+		// another storage class are left as is.
+		void setStoragePolicy(const std::string& name, AttribStorage storage, Size tuple_size = -1);
+		void setStoragePolicy(TypeInfo typeinfo, AttribStorage storage, Size tuple_size = -1);
+		void clearStoragePolicies();
+
+		// Converts this detail in place. Converted attributes are replaced,
+		// Attrib handles to them are invalidated.
+		void applyStoragePolicies();
+
+		///
+
+		// Public and topology attributes, index maps and the detail total
+		MemoryUsage memoryUsage() const;
+
+		// Attributes whose name, storage, tuple size, element count and content
+		// match an attribute of `other` take over its data, pages stay shared
+		// until either side writes them. Candidates are compared value by value,
+		// numeric pages in parallel. Returns the shared attributes; skipping
+		// their upload on the caller's side (e.g. in the importer) is not done
+		// here.
+		std::vector<Attrib> shareAttribs(const Geometry& other);
+
+		static LiveMemoryUsage liveMemoryUsage();
+
 		///
 
 	    void filterPrimitiveByType(std::vector<PrimitiveTypes> prim_types);
@@ -710,8 +1424,134 @@ namespace hio {
 	private:
 
 		GU_Detail _geo;
+
+		std::map<std::string, StoragePolicy> _name_policies;
+		std::map<TypeInfo, StoragePolicy> _typeinfo_policies;
+
+		// Path of the last load(), packed disk paths resolve against it
+		std::string _source_path;
+
+		// Bytes this Geometry last added to the live total
+		int64 _tracked_bytes = 0;
+
+		void trackMemoryUsage();
+	};
+
+	// One detail per key (e.g. per image sequence), kept alive between frames.
+	// acquire() hands back the same Geometry, recycled.
+	class GeometryPool
+	{
+	public:
+
+		std::shared_ptr<Geometry> acquire(const std::string& key);
+		void release(const std::string& key);
+		void clear();
+
+		Size size() const;
+		std::vector<std::string> keys() const;
+
+	private:
+
+		mutable std::mutex _mutex;
+		std::map<std::string, std::shared_ptr<Geometry>> _pool;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Numeric layer of exportMesh(), `size` elements of the layer's class
+	// with `tuple_size` float or int32 components each
+	struct MeshLayer
+	{
+		std::string name;
+		AttribType type;
+		TypeInfo typeinfo;
+		AttribData data_type;
+		Size tuple_size;
+		Size size;
+		const void* data;
+
+		// Int64 for 64 bit int data (ids, hashes), Invalid for float/int32
+		AttribStorage storage = AttribStorage::Invalid;
+	};
+
+
+	// String layer of exportMesh(), one table index per element (-1 for none)
+	struct MeshStringLayer
+	{
+		std::string name;
+		AttribType type;
+		std::vector<std::string> table;
+		Size size;
+		const int* indices;
+	};
+
+	// Borrowed buffers describing a polygon mesh. Loops are the polygon
+	// corners, `loose_edges` become two point open polygons after the faces.
+	struct MeshArrays
+	{
+		Size num_points = 0;
+		const Vector3* positions = nullptr;
+
+		Size num_loops = 0;
+		const Index* loop_points = nullptr;
+
+		Size num_faces = 0;
+		const Size* loop_totals = nullptr;
+
+		Size num_loose_edges = 0;
+		const Index* loose_edges = nullptr;
+
+		std::vector<MeshLayer> layers;
+		std::vector<MeshStringLayer> string_layers;
+	};
+
+	struct MeshExportOptions
+	{
+		std::map<TypeInfo, StoragePolicy> typeinfo_policies;
+
+		// Geometry::weldPoints() after the build, negative disables it
+		float weld_tolerance = -1;
+		bool weld_average = false;
+
+		// Geometry::reorderForLocality() after welding
+		bool reorder = false;
 	};
 
+	// Builds the detail from `arrays` and saves it, touches no Python state
+	bool exportMesh(const std::string& path, const MeshArrays& arrays, const MeshExportOptions& options = MeshExportOptions());
+
+	/////////////////////////////////////////////////////
+
+	template <typename T>
+	inline void ElementRange::attribValue(const Attrib& attr, T* out_data) const
+	{
+		if (attr.type() != _type)
+			throw std::runtime_error("Attribute class mismatch");
+
+		if (isContiguous())
+		{
+			attr.attribValue<T>(out_data, _start, _count);
+			return;
+		}
+
+		attr.gatherValue<T>(_indices.data(), _count, out_data);
+	}
+
+	template <typename T>
+	inline void ElementRange::setAttribValue(Attrib& attr, const T* in_data)
+	{
+		if (attr.type() != _type)
+			throw std::runtime_error("Attribute class mismatch");
+
+		if (isContiguous())
+		{
+			attr.setAttribValue<T>(in_data, _start, _count);
+			return;
+		}
+
+		attr.scatterValue<T>(_indices.data(), _count, in_data);
+	}
+
 	/////////////////////////////////////////////////////
 
 	template <typename T>
@@ -740,7 +1580,8 @@ namespace hio {
 		hio::Geometry::addAttrib(AttribType type,
 			const std::string& name,
 			const std::vector<T>& default_value,
-			TypeInfo typeinfo)
+			TypeInfo typeinfo,
+			AttribStorage storage)
 	{}
 
 	template <>
@@ -748,12 +1589,18 @@ namespace hio {
 		hio::Geometry::addAttrib(AttribType type,
 			const std::string& name,
 			const std::vector<float>& default_value,
-			TypeInfo typeinfo)
+			TypeInfo typeinfo,
+			AttribStorage storage)
 	{
 		GA_AttributeOwner t = Enum2Enum(type);
+		GA_Storage store = storage == AttribStorage::Invalid ? GA_STORE_REAL32 : Enum2Enum(storage);
+		if (GAgetStorageClass(store) != GA_STORECLASS_FLOAT)
+			throw std::runtime_error("Storage type mismatch");
+
 		GA_Attribute* attr = _geo.addFloatTuple(t, name.c_str(),
 			default_value.size(),
-			GA_Defaults(default_value.data(), default_value.size()));
+			GA_Defaults(default_value.data(), default_value.size()),
+			nullptr, nullptr, store);
 		attr->setTypeInfo(Enum2Enum(typeinfo));
 		return Attrib_<float>(attr);
 	}
@@ -763,12 +1610,18 @@ namespace hio {
 		hio::Geometry::addAttrib(AttribType type,
 			const std::string& name,
 			const std::vector<int>& default_value,
-			TypeInfo typeinfo)
+			TypeInfo typeinfo,
+			AttribStorage storage)
 	{
 		GA_AttributeOwner t = Enum2Enum(type);
+		GA_Storage store = storage == AttribStorage::Invalid ? GA_STORE_INT32 : Enum2Enum(storage);
+		if (GAgetStorageClass(store) != GA_STORECLASS_INT)
+			throw std::runtime_error("Storage type mismatch");
+
 		GA_Attribute* attr = _geo.addIntTuple(t, name.c_str(),
 			default_value.size(),
-			GA_Defaults(default_value.data(), default_value.size()));
+			GA_Defaults(default_value.data(), default_value.size()),
+			nullptr, nullptr, store);
 		attr->setTypeInfo(Enum2Enum(typeinfo));
 		return Attrib_<int>(attr);
 	}
@@ -778,7 +1631,8 @@ namespace hio {
 		hio::Geometry::addAttrib(AttribType type,
 			const std::string& name,
 			const std::vector<std::string>& default_value,
-			TypeInfo typeinfo)
+			TypeInfo typeinfo,
+			AttribStorage storage)
 	{
 
 		GA_AttributeOwner t = Enum2Enum(type);
@@ -1,7 +1,14 @@
 #include <math.h>
 #include <iostream>
+#include <numeric>
+#include <algorithm>
 #include "hio.h"
 
+#include <GU/GU_PrimMesh.h>
+#include <GU/GU_PackedGeometry.h>
+#include <GU/GU_PrimPart.h>
+#include <GU/GU_PrimVolume.h>
+
 using namespace hio;
 
 #define CATCH_CONFIG_RUNNER
@@ -447,6 +454,1059 @@ TEST_CASE("prim_curves" "[hio]") {
 	REQUIRE(std::equal(NP.begin(), NP.end(), NNP.begin(), NNP.end()));
 }
 
+TEST_CASE("cornerNormals", "[hio]") {
+	Geometry geo;
+
+	std::vector<Vector3> points = {
+		{0, 0, 0},
+		{1, 0, 0},
+		{1, 1, 0},
+		{0, 1, 0},
+	};
+	std::vector<Size> vertex_counts = { 4 };
+
+	geo.createPolygons(points.size(), points.data(), vertex_counts.size(), vertex_counts.data(), true);
+
+	std::vector<Vector3> out(geo.getNumVertices());
+	REQUIRE_THROWS(geo.cornerNormals(out.data()));
+
+	auto pN = geo.addAttrib<float>(AttribType::Point, "N", std::vector<float>({ 0, 0, 0 }), TypeInfo::Normal);
+	std::vector<Vector3> pN_data(geo.getNumPoints(), Vector3(0, 0, 2));
+	pN.setAttribValue<float>(pN_data.data());
+
+	geo.cornerNormals(out.data(), true);
+	for (const auto& n : out)
+		REQUIRE(n == Vector3(0, 0, -1));
+
+	auto vN = geo.addAttrib<float>(AttribType::Vertex, "N", std::vector<float>({ 0, 3, 0 }), TypeInfo::Normal);
+	REQUIRE(vN);
+
+	geo.cornerNormals(out.data());
+	for (const auto& n : out)
+		REQUIRE(n == Vector3(0, 1, 0));
+}
+
+TEST_CASE("curveData", "[hio]") {
+	Geometry geo;
+	auto B = geo.createBezierCurve(7);
+	auto N = geo.createNURBSCurve(5, false, 3);
+
+	std::vector<Vector3> BP(7), NP(5);
+	for (int i = 0; i < 7; i++)
+		BP[i] = Vector3(i, 0, 0);
+	for (int i = 0; i < 5; i++)
+		NP[i] = Vector3(i, 1, 0);
+
+	B.setPositions(BP.data(), 0, BP.size());
+	N.setPositions(NP.data(), 0, NP.size());
+
+	CurveData data;
+	geo.curveData(data);
+
+	REQUIRE(data.type.size() == 2);
+	REQUIRE(data.type[0] == (int)PrimitiveTypes::BezierCurve);
+	REQUIRE(data.type[1] == (int)PrimitiveTypes::NURBSCurve);
+	REQUIRE(data.order[0] == 4);
+	REQUIRE(data.order[1] == 3);
+	REQUIRE(data.endpoint[1] == 1);
+
+	REQUIRE(data.vertex_start == std::vector<Index>({ 0, 7, 12 }));
+	REQUIRE(data.positions[8] == Vector4(1, 1, 0, 1));
+	REQUIRE(data.knot_start.back() == data.knots.size());
+
+	REQUIRE(data.anchor_start == std::vector<Index>({ 0, 3, 3 }));
+	REQUIRE(data.anchors[1] == Vector3(3, 0, 0));
+	REQUIRE(data.handle_left[0] == Vector3(0, 0, 0));
+	REQUIRE(data.handle_left[1] == Vector3(2, 0, 0));
+	REQUIRE(data.handle_right[1] == Vector3(4, 0, 0));
+	REQUIRE(data.handle_right[2] == Vector3(6, 0, 0));
+}
+
+TEST_CASE("stringTable", "[hio]") {
+	Geometry geo;
+
+	for (int i = 0; i < 5; i++)
+		geo.createPolygon();
+
+	auto name = geo.addAttrib<std::string>(AttribType::Prim, "name", std::vector<std::string>(1), TypeInfo::Value);
+
+	std::vector<std::string> table = { "piece0", "piece1" };
+	std::vector<int> indices = { 1, 0, -1, 1, 1 };
+
+	REQUIRE_THROWS(name.setStringTable(table, std::vector<int>({ 0, 1, 2, 0, 0 }).data()));
+	REQUIRE_NOTHROW(name.setStringTable(table, indices.data()));
+
+	std::string s;
+	name.attribValue<std::string>(&s, 3, 1);
+	REQUIRE(s == "piece1");
+
+	std::vector<std::string> out_table;
+	std::vector<int> out_indices(5);
+	name.stringTable(out_table, out_indices.data());
+
+	REQUIRE(out_table.size() == 2);
+	for (int i = 0; i < 5; i++)
+	{
+		if (indices[i] < 0)
+			REQUIRE(out_indices[i] == -1);
+		else
+			REQUIRE(out_table[out_indices[i]] == table[indices[i]]);
+	}
+}
+
+TEST_CASE("readAttribs", "[hio]") {
+	Geometry geo;
+	geo.createPoints(3000);
+
+	auto Cd = geo.addAttrib<float>(AttribType::Point, "Cd", std::vector<float>({ 1, 0.5, 0 }), TypeInfo::Color);
+	auto id = geo.addAttrib<int>(AttribType::Point, "id", std::vector<int>({ 0 }), TypeInfo::Value);
+
+	std::vector<int> ids(geo.getNumPoints());
+	std::iota(ids.begin(), ids.end(), 0);
+	id.setAttribValue<int>(ids.data());
+
+	std::vector<Vector3> Cd_out(geo.getNumPoints());
+	std::vector<int> id_out(geo.getNumPoints());
+
+	geo.readAttribs({ Cd, id }, { Cd_out.data(), id_out.data() });
+
+	REQUIRE(Cd_out.front() == Vector3(1, 0.5, 0));
+	REQUIRE(Cd_out.back() == Vector3(1, 0.5, 0));
+	REQUIRE(id_out == ids);
+
+	REQUIRE_THROWS(geo.readAttribs({ Cd }, {}));
+}
+
+TEST_CASE("native storage", "[hio]") {
+	Geometry geo;
+	geo.createPoints(3);
+
+	REQUIRE_THROWS(geo.addAttrib<float>(AttribType::Point, "bad", std::vector<float>({ 0 }), TypeInfo::Value, AttribStorage::Int32));
+
+	auto Cd = geo.addAttrib<float>(AttribType::Point, "Cd", std::vector<float>({ 1, 1, 1 }), TypeInfo::Color, AttribStorage::Real16);
+	REQUIRE(Cd.storage() == AttribStorage::Real16);
+	REQUIRE(Cd.dataType() == AttribData::Float);
+
+	std::vector<fpreal16> Cd_in = { 0.5f, 0.25f, 1, 2, 3, 4, 5, 6, 7 };
+	Cd.setAttribValue<fpreal16>(Cd_in.data());
+
+	std::vector<fpreal16> Cd_out(9);
+	Cd.attribValue<fpreal16>(Cd_out.data());
+	REQUIRE(std::equal(Cd_in.begin(), Cd_in.end(), Cd_out.begin()));
+
+	auto id = geo.addAttrib<int>(AttribType::Point, "id", std::vector<int>({ 0 }), TypeInfo::Value, AttribStorage::Int64);
+	REQUIRE(id.storage() == AttribStorage::Int64);
+
+	std::vector<int64> id_in = { int64(1) << 40, 2, -(int64(1) << 40) };
+	id.setAttribValue<int64>(id_in.data());
+
+	std::vector<int64> id_out(3);
+	id.attribValue<int64>(id_out.data());
+	REQUIRE(id_in == id_out);
+
+	auto P = geo.findPointAttrib("P");
+	REQUIRE(P.storage() == AttribStorage::Real32);
+}
+
+TEST_CASE("storage policy", "[hio]") {
+	Geometry geo;
+	geo.createPoints(4);
+
+	auto N = geo.addAttrib<float>(AttribType::Point, "N", std::vector<float>({ 0, 1, 0 }), TypeInfo::Normal);
+	auto uv = geo.addAttrib<float>(AttribType::Point, "uv", std::vector<float>({ 0.5, 0.25, 0 }), TypeInfo::TextureCoord);
+	auto id = geo.addAttrib<int>(AttribType::Point, "id", std::vector<int>({ 3 }), TypeInfo::Value);
+
+	geo.setStoragePolicy(TypeInfo::Normal, AttribStorage::Real16);
+	geo.setStoragePolicy(TypeInfo::TextureCoord, AttribStorage::Real16, 2);
+	geo.setStoragePolicy(TypeInfo::Value, AttribStorage::Real16);
+	geo.setStoragePolicy("id", AttribStorage::Int8);
+	geo.setStoragePolicy(TypeInfo::Point, AttribStorage::Real16);
+
+	REQUIRE(geo.save("geo/out_storage_policy.bgeo"));
+
+	// the saved copy is converted, the live detail is not
+	REQUIRE(N.storage() == AttribStorage::Real32);
+	REQUIRE(uv.tupleSize() == 3);
+	REQUIRE(id.storage() == AttribStorage::Int32);
+
+	Geometry geo2;
+	REQUIRE(geo2.load("geo/out_storage_policy.bgeo"));
+
+	REQUIRE(geo2.findPointAttrib("N").storage() == AttribStorage::Real16);
+	REQUIRE(geo2.findPointAttrib("uv").tupleSize() == 2);
+	REQUIRE(geo2.findPointAttrib("id").storage() == AttribStorage::Int8);
+	REQUIRE(geo2.findPointAttrib("P").storage() == AttribStorage::Real32);
+
+	auto uv2 = geo2.findPointAttrib("uv");
+	REQUIRE(uv2.storage() == AttribStorage::Real16);
+
+	Vector2 v;
+	uv2.attribValue<float>(&v, 0, 1);
+	REQUIRE(v == Vector2(0.5, 0.25));
+}
+
+TEST_CASE("promoteAttrib", "[hio]") {
+	Geometry geo;
+
+	std::vector<Vector3> points = {
+		{0, 0, 0},
+		{1, 0, 0},
+		{1, 1, 0},
+		{0, 1, 0},
+		{2, 0, 0},
+		{2, 1, 0},
+	};
+	std::vector<Index> vertices = { 0, 1, 2, 3, 1, 4, 5, 2 };
+	std::vector<Size> vertex_counts = { 4, 4 };
+
+	geo.createPolygons(points.size(), points.data(), vertices.size(), vertices.data(), vertex_counts.size(), vertex_counts.data(), true);
+
+	auto P = geo.findPointAttrib("P");
+
+	std::vector<Vector3> vtx_P(geo.getNumVertices());
+	geo.promoteAttribValue(P, AttribType::Vertex, (float*)vtx_P.data());
+	REQUIRE(vtx_P[5] == points[4]);
+
+	std::vector<Vector3> prim_P(geo.getNumPrimitives());
+	geo.promoteAttribValue(P, AttribType::Prim, (float*)prim_P.data());
+	REQUIRE(prim_P[0] == Vector3(0.5, 0.5, 0));
+	REQUIRE(prim_P[1] == Vector3(1.5, 0.5, 0));
+
+	auto id = geo.addAttrib<int>(AttribType::Prim, "id", std::vector<int>({ 0 }), TypeInfo::Value);
+	std::vector<int> ids = { 10, 20 };
+	id.setAttribValue<int>(ids.data());
+
+	auto pt_id = geo.promoteAttrib(id, AttribType::Point, "prim_id", PromoteMethod::Average);
+	REQUIRE(pt_id.dataType() == AttribData::Int);
+
+	std::vector<int> pt_ids(geo.getNumPoints());
+	pt_id.attribValue<int>(pt_ids.data());
+	REQUIRE(pt_ids == std::vector<int>({ 10, 15, 15, 10, 20, 20 }));
+
+	auto vtx_id = geo.promoteAttrib(pt_id, AttribType::Vertex, "vtx_id", PromoteMethod::First);
+	int v;
+	vtx_id.attribValue<int>(&v, 4, 1);
+	REQUIRE(v == 15);
+
+	REQUIRE_THROWS(geo.promoteAttribValue(P, AttribType::Global, (float*)vtx_P.data()));
+}
+
+TEST_CASE("triangulate", "[hio]") {
+	Geometry geo;
+
+	// convex quad and a concave L shape
+	std::vector<Vector3> points = {
+		{0, 0, 0},
+		{1, 0, 0},
+		{1, 1, 0},
+		{0, 1, 0},
+
+		{2, 0, 0},
+		{4, 0, 0},
+		{4, 1, 0},
+		{3, 1, 0},
+		{3, 2, 0},
+		{2, 2, 0},
+	};
+	std::vector<Size> vertex_counts = { 4, 6 };
+
+	geo.createPolygons(points.size(), points.data(), vertex_counts.size(), vertex_counts.data(), true);
+
+	Triangles tris;
+	geo.triangulate(tris);
+
+	REQUIRE(tris.prims == std::vector<Index>({ 0, 0, 1, 1, 1, 1 }));
+	REQUIRE(tris.points.size() == 18);
+	REQUIRE(tris.vertices.size() == 18);
+
+	// fan for the convex quad
+	REQUIRE(std::vector<Index>(tris.points.begin(), tris.points.begin() + 6) == std::vector<Index>({ 0, 1, 2, 0, 2, 3 }));
+
+	// area is preserved and all triangles keep the polygon winding
+	float area = 0;
+	for (size_t t = 2; t < tris.prims.size(); t++)
+	{
+		Vector3 a = points[tris.points[t * 3]], b = points[tris.points[t * 3 + 1]], c = points[tris.points[t * 3 + 2]];
+		float z = cross(b - a, c - a).z() * 0.5f;
+		REQUIRE(z > 0);
+		area += z;
+	}
+	REQUIRE(area == Approx(3.0f));
+}
+
+TEST_CASE("meshQuads", "[hio]") {
+	Geometry geo;
+
+	// open 3x4 grid and a 3x3 grid wrapped in u
+	GU_PrimMesh::build(&geo.geo(), 3, 4, GEO_PATCH_QUADS, 0, 0);
+	GU_PrimMesh::build(&geo.geo(), 3, 3, GEO_PATCH_QUADS, 1, 0);
+
+	MeshQuads quads;
+	geo.meshQuads(quads);
+
+	REQUIRE(quads.prims.size() == 2 * 3 + 2 * 3);
+	REQUIRE(quads.points.size() == quads.prims.size() * 4);
+	REQUIRE(quads.vertices.size() == quads.prims.size() * 4);
+
+	REQUIRE(std::count(quads.prims.begin(), quads.prims.end(), 0) == 6);
+	REQUIRE(std::count(quads.prims.begin(), quads.prims.end(), 1) == 6);
+
+	// first quad of the open grid
+	REQUIRE(std::vector<Index>(quads.points.begin(), quads.points.begin() + 4) == std::vector<Index>({ 0, 1, 5, 4 }));
+
+	// last column of the wrapped grid closes back to column 0
+	const Index q = 6 + 2;
+	REQUIRE(quads.points[q * 4 + 1] == 12 + 0);
+	REQUIRE(quads.points[q * 4 + 2] == 12 + 3);
+}
+
+TEST_CASE("packedInstances", "[hio]") {
+	Geometry src;
+
+	std::vector<Vector3> points = { {0, 0, 0}, {1, 0, 0}, {1, 1, 0} };
+	std::vector<Size> vertex_counts = { 3 };
+	src.createPolygons(points.size(), points.data(), vertex_counts.size(), vertex_counts.data(), true);
+
+	GU_Detail* gdp = new GU_Detail;
+	gdp->replaceWith(src.geo());
+
+	GU_DetailHandle gdh;
+	gdh.allocateAndSet(gdp);
+
+	Geometry geo;
+	GU_PrimPacked* packed = GU_PackedGeometry::packGeometry(geo.geo(), gdh);
+	geo.geo().setPos3(packed->getPointOffset(0), UT_Vector3(1, 2, 3));
+
+	PackedInstances instances;
+	geo.packedInstances(instances);
+
+	REQUIRE(instances.prims == std::vector<Index>({ 0 }));
+	REQUIRE(instances.prototype == std::vector<Index>({ 0 }));
+	REQUIRE(instances.paths == std::vector<std::string>({ "" }));
+	REQUIRE(instances.prototypes.size() == 1);
+	REQUIRE(instances.prototypes[0]->getNumPrimitives() == 1);
+	REQUIRE(instances.prototypes[0]->getNumPoints() == 3);
+
+	const Matrix4& m = instances.transforms[0];
+	REQUIRE(m(3, 0) == Approx(1));
+	REQUIRE(m(3, 1) == Approx(2));
+	REQUIRE(m(3, 2) == Approx(3));
+}
+
+TEST_CASE("groups", "[hio]") {
+	Geometry geo;
+	geo.createPoints(10);
+
+	GA_PointGroup* pin = geo.geo().newPointGroup("pin");
+	for (GA_Offset off : { 1, 3, 8, 9 })
+		pin->addOffset(off);
+
+	geo.geo().newPointGroup("empty");
+
+	std::vector<std::string> names = geo.groupNames(AttribType::Point);
+	std::sort(names.begin(), names.end());
+	REQUIRE(names == std::vector<std::string>({ "empty", "pin" }));
+
+	std::vector<std::vector<Index>> indices;
+	geo.groupIndices(AttribType::Point, { "pin", "empty" }, indices);
+	REQUIRE(indices[0] == std::vector<Index>({ 1, 3, 8, 9 }));
+	REQUIRE(indices[1].empty());
+
+	std::vector<uint8_t> mask(2, 0xff);
+	geo.groupMasks(AttribType::Point, { "pin" }, { mask.data() });
+	REQUIRE(mask[0] == ((1 << 1) | (1 << 3)));
+	REQUIRE(mask[1] == ((1 << 0) | (1 << 1)));
+
+	REQUIRE_THROWS(geo.groupIndices(AttribType::Point, { "missing" }, indices));
+}
+
+TEST_CASE("edges", "[hio]") {
+	Geometry geo;
+
+	// two triangles sharing the edge 1-2
+	std::vector<Vector3> points = {
+		{0, 0, 0},
+		{1, 0, 0},
+		{0, 1, 0},
+		{1, 1, 0},
+		{2, 0, 0},
+		{3, 0, 0},
+	};
+	std::vector<Index> vertices = { 0, 1, 2, 2, 1, 3 };
+	std::vector<Size> vertex_counts = { 3, 3 };
+	geo.createPolygons(points.size(), points.data(), vertices.size(), vertices.data(), vertex_counts.size(), vertex_counts.data(), true);
+
+	// open polyline 3-4-5
+	std::vector<Index> line = { 3, 4, 5 };
+	std::vector<Size> line_counts = { 3 };
+	REQUIRE(geo.createPolylines(line.size(), line.data(), line_counts.size(), line_counts.data()) == 2);
+	REQUIRE(geo.getNumPrimitives() == 3);
+	REQUIRE(geo.getNumVertices() == 9);
+
+	Edges edges;
+	geo.edges(edges);
+
+	REQUIRE(edges.edges == std::vector<Index>({ 0, 1, 0, 2, 1, 2, 1, 3, 2, 3, 3, 4, 4, 5 }));
+	REQUIRE(edges.corner_edge == std::vector<Index>({ 0, 2, 1, 2, 3, 4, 5, 6, -1 }));
+}
+
+TEST_CASE("createPolylines with holes", "[hio]") {
+	Geometry geo;
+
+	std::vector<Vector3> points = { { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 }, { 3, 0, 0 } };
+	geo.createPoints(points.size(), points.data());
+
+	// point index 0 is now at x = 1
+	geo.geo().destroyPointOffset(GA_Offset(0));
+
+	std::vector<Index> line = { 0, 2 };
+	std::vector<Size> counts = { 2 };
+	geo.createPolylines(line.size(), line.data(), counts.size(), counts.data());
+
+	const GU_Detail& gdp = geo.geo();
+	const GA_Primitive* prim = gdp.getPrimitiveByIndex(0);
+	REQUIRE(gdp.getPos3(prim->getPointOffset(0)).x() == 1.0f);
+	REQUIRE(gdp.getPos3(prim->getPointOffset(1)).x() == 3.0f);
+
+	std::vector<Index> bad = { 0, 3 };
+	REQUIRE_THROWS(geo.createPolylines(bad.size(), bad.data(), counts.size(), counts.data()));
+}
+
+TEST_CASE("pointCloud", "[hio]") {
+	Geometry geo;
+
+	std::vector<Vector3> points(8);
+	for (size_t i = 0; i < points.size(); i++)
+		points[i] = Vector3(float(i), 0, 0);
+	geo.createPoints(points.size(), points.data());
+
+	REQUIRE(geo.isPointCloud());
+
+	std::vector<Index> indices;
+	geo.particlePoints(indices);
+	REQUIRE(indices.size() == 8);
+
+	// particle system over the last three points
+	GEO_PrimParticle* part = GU_PrimParticle::build(&geo.geo(), 0);
+	for (GA_Offset off : { 5, 6, 7 })
+		part->appendParticle(off);
+
+	REQUIRE(geo.isPointCloud());
+
+	geo.particlePoints(indices);
+	REQUIRE(indices == std::vector<Index>({ 5, 6, 7 }));
+
+	std::vector<Vector3> P(indices.size());
+	geo.readPointAttribs({ geo.findPointAttrib("P") }, indices, { P.data() });
+	REQUIRE(P[0].x() == Approx(5));
+	REQUIRE(P[2].x() == Approx(7));
+
+	geo.createPolygon(3);
+	REQUIRE(!geo.isPointCloud());
+}
+
+TEST_CASE("volumes", "[hio]") {
+	Geometry geo;
+
+	// spans several tiles with partial tiles at the upper ends
+	GU_PrimVolume* vol = (GU_PrimVolume*)GU_PrimVolume::build(&geo.geo());
+	{
+		UT_VoxelArrayWriteHandleF handle = vol->getVoxelWriteHandle();
+		handle->size(20, 18, 17);
+		for (int z = 0; z < 17; z++)
+			for (int y = 0; y < 18; y++)
+				for (int x = 0; x < 20; x++)
+					handle->setValue(x, y, z, float(x + 100 * y + 10000 * z));
+	}
+
+	std::vector<VolumeInfo> infos;
+	geo.volumeInfos(infos);
+	REQUIRE(infos.size() == 1);
+	REQUIRE(infos[0].resolution[0] == 20);
+	REQUIRE(infos[0].resolution[1] == 18);
+	REQUIRE(infos[0].resolution[2] == 17);
+
+	UT_Vector3 expected;
+	vol->indexToPos(2, 3, 4, expected);
+	Vector4 pos = Vector4(2, 3, 4, 1) * infos[0].transform;
+	REQUIRE(pos.x() == Approx(expected.x()));
+	REQUIRE(pos.y() == Approx(expected.y()));
+	REQUIRE(pos.z() == Approx(expected.z()));
+
+	std::vector<float> voxels(20 * 18 * 17);
+	geo.readVolumes({ 0 }, { voxels.data() });
+	REQUIRE(voxels[(19 * 18 + 17) * 17 + 16] == Approx(19 + 1700 + 160000));
+	REQUIRE(voxels[(5 * 18 + 3) * 17 + 2] == Approx(5 + 300 + 20000));
+
+	// every third voxel
+	geo.volumeInfos(infos, 3);
+	REQUIRE(infos[0].resolution[0] == 7);
+	REQUIRE(infos[0].resolution[1] == 6);
+	REQUIRE(infos[0].resolution[2] == 6);
+
+	std::vector<float> preview(7 * 6 * 6);
+	geo.readVolumes({ 0 }, { preview.data() }, 3);
+	REQUIRE(preview[(6 * 6 + 5) * 6 + 5] == Approx(18 + 1500 + 150000));
+	REQUIRE(preview[(2 * 6 + 1) * 6 + 4] == Approx(6 + 300 + 120000));
+}
+
+TEST_CASE("createPolygonBlock", "[hio]") {
+	Geometry geo;
+
+	// existing points keep their positions
+	std::vector<Vector3> existing = { {9, 9, 9}, {8, 8, 8} };
+	geo.createPoints(existing.size(), existing.data());
+	geo.createPoints(existing.size(), existing.data());
+	REQUIRE(geo.point(1).position(geo) == Vector3(8, 8, 8));
+	REQUIRE(geo.point(2).position(geo) == Vector3(9, 9, 9));
+
+	std::vector<Vector3> points = {
+		{0, 0, 0},
+		{1, 0, 0},
+		{1, 1, 0},
+		{0, 1, 0},
+		{2, 0, 0},
+	};
+	std::vector<Index> vertices = { 0, 1, 2, 3, 1, 4, 2 };
+	std::vector<Size> vertex_counts = { 4, 3 };
+
+	REQUIRE(geo.createPolygonBlock(points.size(), points.data(), vertices.size(), vertices.data(), vertex_counts.size(), vertex_counts.data()) == 0);
+	REQUIRE(geo.getNumPoints() == 9);
+	REQUIRE(geo.getNumPrimitives() == 2);
+	REQUIRE(geo.getNumVertices() == 7);
+
+	REQUIRE(geo.point(0).position(geo) == Vector3(9, 9, 9));
+	REQUIRE(geo.point(8).position(geo) == Vector3(2, 0, 0));
+
+	Polygon tri = geo.prim(1);
+	REQUIRE(tri.isClosed());
+	REQUIRE(tri.vertexCount() == 3);
+	REQUIRE(geo.geo().vertexPoint(geo.geo().getPrimitiveVertexOffset(geo.geo().primitiveOffset(1), 1)) == 4 + 4);
+
+	std::vector<Index> bad = { 0, 1, 5 };
+	std::vector<Size> bad_counts = { 3 };
+	REQUIRE_THROWS(geo.createPolygonBlock(points.size(), points.data(), bad.size(), bad.data(), bad_counts.size(), bad_counts.data()));
+}
+
+TEST_CASE("createCurves", "[hio]") {
+	Geometry geo;
+
+	// open bezier with 3 anchors and a closed one with 2, as (left, anchor, right)
+	std::vector<Vector3> bezier;
+	for (int i = 0; i < 5; i++)
+	{
+		bezier.emplace_back(float(i), -1, 0);
+		bezier.emplace_back(float(i), 0, 0);
+		bezier.emplace_back(float(i), 1, 0);
+	}
+	std::vector<Size> bezier_counts = { 3, 2 };
+	std::vector<int> bezier_orders = { 4, 4 };
+	std::vector<int> bezier_closed = { 0, 1 };
+
+	REQUIRE(geo.createCurves(PrimitiveTypes::BezierCurve, 2, bezier_counts.data(), bezier_orders.data(), bezier_closed.data(),
+		bezier.size(), bezier.data()) == 0);
+
+	REQUIRE(geo.getNumPrimitives() == 2);
+	REQUIRE(geo.getNumPoints() == 7 + 6);
+
+	// a0 r0 l1 a1 r1 l2 a2
+	REQUIRE(geo.point(1).position(geo) == Vector3(0, 1, 0));
+	REQUIRE(geo.point(2).position(geo) == Vector3(1, -1, 0));
+	REQUIRE(geo.point(6).position(geo) == Vector3(2, 0, 0));
+
+	// closed curve ends with the left handle of its first anchor
+	REQUIRE(geo.point(7).position(geo) == Vector3(3, 0, 0));
+	REQUIRE(geo.point(12).position(geo) == Vector3(3, -1, 0));
+
+	BezierCurve closed_curve = geo.prim(1);
+	REQUIRE(closed_curve.isClosed());
+	REQUIRE(closed_curve.vertexCount() == 6);
+
+	std::vector<Vector3> nurbs = { {0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0} };
+	std::vector<float> weights = { 1, 2, 3, 4 };
+	std::vector<Size> nurbs_counts = { 4 };
+	std::vector<int> nurbs_orders = { 3 };
+	std::vector<int> nurbs_closed = { 0 };
+
+	REQUIRE(geo.createCurves(PrimitiveTypes::NURBSCurve, 1, nurbs_counts.data(), nurbs_orders.data(), nurbs_closed.data(),
+		nurbs.size(), nurbs.data(), weights.data()) == 2);
+
+	NURBSCurve curve = geo.prim(2);
+	REQUIRE(curve.vertexCount() == 4);
+	REQUIRE(curve.curve()->getOrder() == 3);
+
+	std::vector<float> Pw(geo.getNumPoints());
+	geo.findPointAttrib("Pw").attribValue<float>(Pw.data());
+	REQUIRE(Pw[0] == 1);
+	REQUIRE(Pw[13 + 3] == 4);
+
+	// a single point curve is skipped, the second one keeps open ends
+	std::vector<Vector3> more = { {0, 0, 0}, {0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0} };
+	std::vector<Size> more_counts = { 1, 4 };
+	std::vector<int> more_orders = { 3, 3 };
+	std::vector<int> more_closed = { 0, 0 };
+	std::vector<int> more_ends = { 1, 0 };
+
+	REQUIRE(geo.createCurves(PrimitiveTypes::NURBSCurve, 2, more_counts.data(), more_orders.data(), more_closed.data(),
+		more.size(), more.data(), nullptr, more_ends.data()) == 3);
+	REQUIRE(geo.getNumPrimitives() == 4);
+
+	NURBSCurve open_ends = geo.prim(3);
+	REQUIRE(open_ends.vertexCount() == 4);
+	REQUIRE(!open_ends.curve()->getEndInterpolation());
+
+	// order 4 on 2 points is clamped to the point count
+	std::vector<Size> short_counts = { 2 };
+	std::vector<int> short_orders = { 4 };
+	REQUIRE(geo.createCurves(PrimitiveTypes::NURBSCurve, 1, short_counts.data(), short_orders.data(), more_closed.data(),
+		2, more.data()) == 4);
+
+	NURBSCurve short_curve = geo.prim(4);
+	REQUIRE(short_curve.curve()->getOrder() == 2);
+}
+
+TEST_CASE("exportMesh", "[hio]") {
+	std::vector<Vector3> positions = { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0} };
+	std::vector<Index> loop_points = { 0, 1, 2, 3 };
+	std::vector<Size> loop_totals = { 4 };
+	std::vector<Index> loose_edges = { 1, 4 };
+
+	std::vector<Vector3> normals(4, Vector3(0, 0, 1));
+	std::vector<int> ids = { 7 };
+	std::vector<int> materials = { 1 };
+	std::vector<int64> hashes = { int64(1) << 40 };
+
+	MeshArrays arrays;
+	arrays.num_points = positions.size();
+	arrays.positions = positions.data();
+	arrays.num_loops = loop_points.size();
+	arrays.loop_points = loop_points.data();
+	arrays.num_faces = loop_totals.size();
+	arrays.loop_totals = loop_totals.data();
+	arrays.num_loose_edges = 1;
+	arrays.loose_edges = loose_edges.data();
+	arrays.layers.push_back({ "N", AttribType::Vertex, TypeInfo::Normal, AttribData::Float, 3, 4, normals.data() });
+	arrays.layers.push_back({ "id", AttribType::Prim, TypeInfo::Value, AttribData::Int, 1, 1, ids.data() });
+	arrays.layers.push_back({ "hash", AttribType::Prim, TypeInfo::Value, AttribData::Int, 1, 1, hashes.data(), AttribStorage::Int64 });
+	arrays.string_layers.push_back({ "shop_materialpath", AttribType::Prim, { "a", "b" }, 1, materials.data() });
+
+	MeshExportOptions options;
+	options.typeinfo_policies[TypeInfo::Normal] = { AttribStorage::Real16, -1 };
+
+	REQUIRE(exportMesh("geo/out_export_mesh.bgeo", arrays, options));
+
+	Geometry geo;
+	REQUIRE(geo.load("geo/out_export_mesh.bgeo"));
+	REQUIRE(geo.getNumPoints() == 5);
+	REQUIRE(geo.getNumPrimitives() == 2);
+	REQUIRE(geo.getNumVertices() == 6);
+	REQUIRE(!Polygon(geo.prim(1)).isClosed());
+
+	REQUIRE(geo.findVertexAttrib("N").storage() == AttribStorage::Real16);
+
+	std::vector<int> id(2);
+	geo.findPrimAttrib("id").attribValue<int>(id.data());
+	REQUIRE(id[0] == 7);
+
+	// 64 bit ints are not truncated
+	Attrib hash = geo.findPrimAttrib("hash");
+	REQUIRE(hash.storage() == AttribStorage::Int64);
+
+	int64 hash_value = 0;
+	hash.attr()->getAIFTuple()->get(hash.attr(), geo.geo().primitiveOffset(0), hash_value);
+	REQUIRE(hash_value == hashes[0]);
+
+	std::vector<std::string> table;
+	std::vector<int> indices(2);
+	geo.findPrimAttrib("shop_materialpath").stringTable(table, indices.data());
+	REQUIRE(table[indices[0]] == "b");
+	REQUIRE(indices[1] == -1);
+
+	// layer sizes must match their element class
+	arrays.layers[1].size = 2;
+	REQUIRE_THROWS(exportMesh("geo/out_export_mesh.bgeo", arrays));
+}
+
+TEST_CASE("ranges", "[hio]") {
+	Geometry geo;
+
+	std::vector<Vector3> points = { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0} };
+	PointRange pts = geo.createPointRange(points.size(), points.data());
+	REQUIRE(pts.size() == 5);
+	REQUIRE(pts.isContiguous());
+
+	std::vector<Index> vertices = { 0, 1, 2, 3, 1, 4, 2 };
+	std::vector<Size> vertex_counts = { 4, 3 };
+	geo.createPolygonBlock(points.size(), points.data(), vertices.size(), vertices.data(), vertex_counts.size(), vertex_counts.data());
+
+	// positions of a selection, in selection order
+	PointRange sel = geo.pointSelection({ 4, 0 });
+	std::vector<Vector3> P(2);
+	sel.positions(P.data());
+	REQUIRE(P[0] == Vector3(2, 0, 0));
+	REQUIRE(P[1] == Vector3(0, 0, 0));
+
+	std::vector<Vector3> moved = { {5, 5, 5}, {6, 6, 6} };
+	sel.setPositions(moved.data());
+	REQUIRE(geo.point(4).position(geo) == Vector3(5, 5, 5));
+	REQUIRE(geo.point(0).position(geo) == Vector3(6, 6, 6));
+	REQUIRE(geo.point(1).position(geo) == Vector3(1, 0, 0));
+
+	PrimitiveRange prims = geo.primRange();
+	REQUIRE(prims.size() == 2);
+	REQUIRE(prims[1].vertexCount() == 3);
+
+	std::vector<Size> counts(2);
+	prims.vertexCounts(counts.data());
+	REQUIRE(counts == vertex_counts);
+
+	std::vector<int> closed = { 1, 0 };
+	prims.setClosedFlags(closed.data());
+
+	std::vector<int> flags(2);
+	prims.closedFlags(flags.data());
+	REQUIRE(flags == closed);
+
+	// attributes on a selection
+	Attrib id = geo.addAttrib<int>(AttribType::Prim, "id", { 0 }, TypeInfo::Value);
+	std::vector<int> ids = { 3 };
+	geo.primSelection({ 1 }).setAttribValue<int>(id, ids.data());
+
+	std::vector<int> all(2);
+	prims.attribValue<int>(id, all.data());
+	REQUIRE(all == std::vector<int>({ 0, 3 }));
+
+	REQUIRE_THROWS(geo.primRange(1, 2));
+	REQUIRE_THROWS(geo.pointSelection({ 10 }));
+	REQUIRE_THROWS(prims.attribValue<float>(geo.findPointAttrib("P"), (float*)P.data()));
+}
+
+TEST_CASE("strided writes", "[hio]") {
+	Geometry geo;
+
+	const Size n = 3000;
+	geo.createPoints(n);
+
+	// 4 component float64 rows, only xyz are written, starting mid page
+	std::vector<double> pts(n * 4);
+	for (Size i = 0; i < n; i++)
+	{
+		pts[i * 4 + 0] = double(i);
+		pts[i * 4 + 1] = double(i) * 2;
+		pts[i * 4 + 2] = double(i) * 3;
+		pts[i * 4 + 3] = -1;
+	}
+
+	Attrib P = geo.findPointAttrib("P");
+	P.setAttribValueStrided(pts.data(), AttribStorage::Real64, n - 100, 3, 4 * sizeof(double), sizeof(double), 100);
+
+	std::vector<Vector3> out(n);
+	P.attribValue<float>(out.data());
+	REQUIRE(out[100] == Vector3(0, 0, 0));
+	REQUIRE(out[2999] == Vector3(2899, 5798, 8697));
+
+	// int8 column into a float color, missing components filled
+	std::vector<int8> column = { 1, 2, 3 };
+	Attrib Cd = geo.addAttrib<float>(AttribType::Point, "Cd", { 0, 0, 0 }, TypeInfo::Color);
+	Cd.setAttribValueStrided(column.data(), AttribStorage::Int8, 3, 1, sizeof(int8), sizeof(int8), 0, 0.5);
+
+	std::vector<Vector3> colors(n);
+	Cd.attribValue<float>(colors.data());
+	REQUIRE(colors[2] == Vector3(3, 0.5f, 0.5f));
+	REQUIRE(colors[3] == Vector3(0, 0, 0));
+
+	// float source into a 16 bit int attribute
+	std::vector<float> values = { 1.0f, 2.0f };
+	Attrib id = geo.addAttrib<int>(AttribType::Point, "id", { 0 }, TypeInfo::Value, AttribStorage::Int16);
+	id.setAttribValueStrided(values.data(), AttribStorage::Real32, 2, 1, sizeof(float), sizeof(float), 1500);
+
+	std::vector<int> ids(n);
+	id.attribValue<int>(ids.data());
+	REQUIRE(ids[1500] == 1);
+	REQUIRE(ids[1501] == 2);
+
+	REQUIRE_THROWS(Cd.setAttribValueStrided(pts.data(), AttribStorage::Real64, 1, 4, 4 * sizeof(double), sizeof(double)));
+}
+
+TEST_CASE("gather scatter", "[hio]") {
+	Geometry geo;
+
+	const Size n = 2000;
+	geo.createPoints(n);
+
+	Attrib id = geo.addAttrib<int>(AttribType::Point, "id", { 0 }, TypeInfo::Value);
+
+	std::vector<Index> indices = { 1999, 5, 1024 };
+	std::vector<int> values = { 7, 8, 9 };
+	id.scatterValue<int>(indices.data(), indices.size(), values.data());
+
+	std::vector<int> out(indices.size());
+	id.gatherValue<int>(indices.data(), indices.size(), out.data());
+	REQUIRE(out == values);
+
+	std::vector<int> all(n);
+	id.attribValue<int>(all.data());
+	REQUIRE(all[4] == 0);
+	REQUIRE(all[5] == 8);
+
+	// only masked elements are written, starting at `offset`
+	std::vector<uint8_t> mask = { 1, 0, 1 };
+	std::vector<int> masked = { 1, 2, 3 };
+	id.setAttribValueMasked<int>(mask.data(), masked.data(), 4, 3);
+
+	id.attribValue<int>(all.data());
+	REQUIRE(all[4] == 1);
+	REQUIRE(all[5] == 8);
+	REQUIRE(all[6] == 3);
+
+	std::vector<Index> bad = { 0, n };
+	REQUIRE_THROWS(id.gatherValue<int>(bad.data(), bad.size(), out.data()));
+
+	std::vector<float> fout(1);
+	REQUIRE_THROWS(id.gatherValue<float>(indices.data(), 1, fout.data()));
+
+	// sparse writes only expand the pages they touch
+	geo.createPoints(3000);
+	Attrib mass = geo.addAttrib<float>(AttribType::Point, "mass", { 1 }, TypeInfo::Value);
+
+	std::vector<Index> one = { 10 };
+	std::vector<float> value = { 2 };
+	mass.scatterValue<float>(one.data(), one.size(), value.data());
+
+	const GA_ATINumeric* numeric = GA_ATINumeric::cast(mass.attr());
+	REQUIRE(!numeric->getData().isPageConstant(0));
+	for (GA_PageNum page = 1; page < 5; page++)
+		REQUIRE(numeric->getData().isPageConstant(page));
+
+	// int64 storage is only read and written as int64
+	Attrib hash = geo.addAttrib<int>(AttribType::Point, "hash", std::vector<int>({ 0 }), TypeInfo::Value, AttribStorage::Int64);
+	std::vector<int64> big = { int64(1) << 40 };
+	hash.scatterValue<int64>(one.data(), one.size(), big.data());
+
+	std::vector<int64> big_out(1);
+	hash.gatherValue<int64>(one.data(), one.size(), big_out.data());
+	REQUIRE(big_out == big);
+	REQUIRE_THROWS(hash.gatherValue<int>(one.data(), one.size(), out.data()));
+}
+
+TEST_CASE("weldPoints", "[hio]") {
+	Geometry geo;
+
+	// two quads sharing an edge, each with its own points
+	std::vector<Vector3> positions = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+		{ 1, 0, 0 }, { 2, 0, 0 }, { 2, 1, 0 }, { 1.00001f, 1, 0 },
+	};
+	std::vector<Index> vertices = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	std::vector<Size> counts = { 4, 4 };
+	geo.createPolygonBlock(positions.size(), positions.data(), vertices.size(), vertices.data(), counts.size(), counts.data());
+
+	Attrib weight = geo.addAttrib<float>(AttribType::Point, "weight", { 0 }, TypeInfo::Value);
+	std::vector<float> weights = { 0, 2, 0, 0, 4, 0, 0, 0 };
+	weight.setAttribValue<float>(weights.data());
+
+	REQUIRE(geo.weldPoints(0.001f, true) == 2);
+	REQUIRE(geo.geo().getNumPoints() == 6);
+	REQUIRE(geo.geo().getNumPrimitives() == 2);
+
+	// second quad now starts at the first quad's point 1
+	const GU_Detail& gdp = geo.geo();
+	const GA_Primitive* prim = gdp.getPrimitiveByIndex(1);
+	REQUIRE(gdp.pointIndex(prim->getPointOffset(0)) == 1);
+	REQUIRE(gdp.pointIndex(prim->getPointOffset(3)) == 2);
+
+	std::vector<float> welded(6);
+	weight.attribValue<float>(welded.data());
+	REQUIRE(welded[1] == 3.0f);
+
+	REQUIRE(geo.weldPoints(0.001f) == 0);
+
+	// a quad with a collapsed edge becomes a triangle, a sliver triangle and
+	// a zero length polyline are deleted
+	Geometry degenerate;
+	std::vector<Vector3> points = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 0.00001f, 0 }, { 0, 1, 0 },
+		{ 5, 0, 0 }, { 6, 0, 0 }, { 6.00001f, 0, 0 },
+		{ 9, 0, 0 }, { 9, 0, 0.00001f },
+	};
+	std::vector<Index> polys = { 0, 1, 2, 3, 4, 5, 6 };
+	std::vector<Size> poly_counts = { 4, 3 };
+	degenerate.createPolygonBlock(points.size(), points.data(), polys.size(), polys.data(), poly_counts.size(), poly_counts.data());
+
+	std::vector<Index> line = { 7, 8 };
+	std::vector<Size> line_counts = { 2 };
+	degenerate.createPolylines(line.size(), line.data(), line_counts.size(), line_counts.data());
+
+	REQUIRE(degenerate.weldPoints(0.001f) == 3);
+	REQUIRE(degenerate.getNumPrimitives() == 1);
+	REQUIRE(degenerate.getNumVertices() == 3);
+}
+
+TEST_CASE("reorderForLocality", "[hio]") {
+	Geometry geo;
+
+	// far, near, far, near: the near points have to come first
+	std::vector<Vector3> positions = { { 10, 10, 10 }, { 0, 0, 0 }, { 10, 10, 9 }, { 0, 1, 0 } };
+	geo.createPoints(positions.size(), positions.data());
+
+	Attrib id = geo.addAttrib<int>(AttribType::Point, "id", { 0 }, TypeInfo::Value);
+	std::vector<int> ids = { 0, 1, 2, 3 };
+	id.setAttribValue<int>(ids.data());
+
+	// the second polyline starts at a near point
+	std::vector<Index> vertices = { 0, 2, 1, 3 };
+	std::vector<Size> counts = { 2, 2 };
+	geo.createPolylines(vertices.size(), vertices.data(), counts.size(), counts.data());
+
+	std::vector<Index> point_order, prim_order;
+	geo.reorderForLocality(point_order, prim_order);
+
+	REQUIRE(point_order.size() == 4);
+	REQUIRE(prim_order == std::vector<Index>{ 1, 0 });
+
+	// attributes follow the points
+	std::vector<int> out(4);
+	id.attribValue<int>(out.data());
+	for (Size i = 0; i < 4; i++)
+		REQUIRE(out[i] == int(point_order[i]));
+
+	std::vector<Vector3> P(4);
+	geo.findPointAttrib("P").attribValue<float>(P.data());
+	REQUIRE(P[0].length() < 2);
+	REQUIRE(P[1].length() < 2);
+
+	// topology follows both permutations
+	const GU_Detail& gdp = geo.geo();
+	const GA_Primitive* prim = gdp.getPrimitiveByIndex(0);
+	REQUIRE(point_order[gdp.pointIndex(prim->getPointOffset(0))] == 1);
+}
+
+TEST_CASE("geometry pool", "[hio]") {
+	GeometryPool pool;
+
+	auto geo = pool.acquire("seq");
+	geo->createPoints(100);
+	geo->addAttrib<float>(AttribType::Point, "pscale", { 1 }, TypeInfo::Value);
+
+	// snapshots are independent of later edits
+	auto snapshot = geo->clone();
+
+	// same detail, emptied for the next frame
+	auto next = pool.acquire("seq");
+	REQUIRE(next == geo);
+	REQUIRE(next->getNumPoints() == 0);
+	REQUIRE(pool.size() == 1);
+
+	next->createPoints(50);
+	REQUIRE(next->getNumPoints() == 50);
+	REQUIRE(snapshot->getNumPoints() == 100);
+	REQUIRE(snapshot->findPointAttrib("pscale"));
+
+	next->copyFrom(*snapshot);
+	REQUIRE(next->getNumPoints() == 100);
+
+	REQUIRE(pool.keys() == std::vector<std::string>{ "seq" });
+
+	// a recycled detail loads the same as a fresh one
+	Geometry fresh;
+	REQUIRE(fresh.load("geo/box.bgeo"));
+
+	auto loaded = pool.acquire("seq");
+	REQUIRE(loaded->load("geo/box.bgeo"));
+	REQUIRE(loaded->getNumPoints() == fresh.getNumPoints());
+	REQUIRE(loaded->getNumPrimitives() == fresh.getNumPrimitives());
+	REQUIRE(loaded->getNumVertices() == fresh.getNumVertices());
+
+	pool.release("seq");
+	REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("memoryUsage", "[hio]") {
+	Geometry geo;
+	geo.createPoints(5000);
+
+	// constant until written
+	Attrib mass = geo.addAttrib<float>(AttribType::Point, "mass", { 1 }, TypeInfo::Value);
+	AttribMemory constant = mass.memoryUsage();
+	REQUIRE(constant.pages == 5);
+	REQUIRE(constant.constant_pages == 5);
+
+	std::vector<float> values(5000, 2.0f);
+	values[10] = 3.0f;
+	mass.setAttribValue<float>(values.data());
+
+	AttribMemory expanded = mass.memoryUsage();
+	REQUIRE(expanded.constant_pages < expanded.pages);
+	REQUIRE(expanded.bytes > constant.bytes);
+
+	Attrib tag = geo.addAttrib<std::string>(AttribType::Point, "tag", { "" }, TypeInfo::Value);
+	std::vector<std::string> tags = { "a", "b", "a" };
+	tag.setAttribValue<std::string>(tags.data(), 0, 3);
+	REQUIRE(tag.memoryUsage().strings >= 2);
+
+	MemoryUsage mem = geo.memoryUsage();
+	REQUIRE(mem.attribs.size() >= 3);
+	REQUIRE(mem.total_bytes >= mem.attrib_bytes);
+
+	LiveMemoryUsage live = Geometry::liveMemoryUsage();
+	REQUIRE(live.geometries >= 1);
+	REQUIRE(live.total_bytes > 0);
+	REQUIRE(live.peak_geometries >= live.geometries);
+	REQUIRE(live.peak_bytes >= live.total_bytes);
+}
+
+TEST_CASE("shareAttribs", "[hio]") {
+	const Size n = 3000;
+
+	std::vector<float> uv(n * 2);
+	for (Size i = 0; i < uv.size(); i++)
+		uv[i] = float(i);
+
+	std::vector<float> weights(n, 1.0f);
+
+	auto build = [&](Geometry& geo, float weight) {
+		geo.createPoints(n);
+		geo.addAttrib<float>(AttribType::Point, "uv", { 0, 0 }, TypeInfo::Value).setAttribValue<float>(uv.data());
+
+		std::fill(weights.begin(), weights.end(), weight);
+		geo.addAttrib<float>(AttribType::Point, "weight", { 0 }, TypeInfo::Value).setAttribValue<float>(weights.data());
+	};
+
+	Geometry prev, next;
+	build(prev, 1.0f);
+	build(next, 2.0f);
+
+	// P (all zero) and uv match, weight differs
+	std::vector<Attrib> shared = next.shareAttribs(prev);
+	std::vector<std::string> names;
+	for (const auto& attr : shared)
+		names.push_back(attr.name());
+	std::sort(names.begin(), names.end());
+	REQUIRE(names == std::vector<std::string>{ "P", "uv" });
+
+	// both sides point at the same page data
+	const GA_ATINumeric* prev_data = GA_ATINumeric::cast(prev.findPointAttrib("uv").attr());
+	const GA_ATINumeric* next_data = GA_ATINumeric::cast(next.findPointAttrib("uv").attr());
+	REQUIRE(prev_data->getData().getPageData(0) == next_data->getData().getPageData(0));
+	REQUIRE(prev_data->getData().getPageData(2) == next_data->getData().getPageData(2));
+
+	// writes stay local to one side, other pages stay shared
+	Attrib next_uv = next.findPointAttrib("uv");
+	std::vector<float> zero(2, 0.0f);
+	next_uv.setAttribValue<float>(zero.data(), 5, 1);
+
+	next_data = GA_ATINumeric::cast(next_uv.attr());
+	REQUIRE(prev_data->getData().getPageData(0) != next_data->getData().getPageData(0));
+	REQUIRE(prev_data->getData().getPageData(2) == next_data->getData().getPageData(2));
+
+	std::vector<float> out(n * 2);
+	prev.findPointAttrib("uv").attribValue<float>(out.data());
+	REQUIRE(out[10] == 10.0f);
+
+	next_uv.attribValue<float>(out.data());
+	REQUIRE(out[10] == 0.0f);
+}
+
 int main(int argc, char* const argv[]) {
 	int result = Catch::Session().run(argc, argv);
 	system("pause");
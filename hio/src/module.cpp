@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 
 #ifdef _WIN32
 #define ssize_t ptrdiff_t
@@ -18,6 +19,70 @@ namespace py = pybind11;
 #define DEFINE_VECTOR_PROP(CLS, NAME) \
 	.def_property(#NAME, [](const CLS& self) -> float { return self.NAME(); }, [](CLS& self, float v) { self.NAME() = v; }, py::return_value_policy::copy)
 
+template <typename T, typename V>
+py::array_t<T> toArray(const std::vector<V>& v, Size tuple_size = 1)
+{
+	Size size = v.size() * (sizeof(V) / sizeof(T)) / tuple_size;
+
+	if (tuple_size == 1)
+		return py::array_t<T>(size, (const T*)v.data());
+
+	return py::array_t<T>(std::vector<Size>{ size, tuple_size }, (const T*)v.data());
+}
+
+template <typename T>
+py::dtype storageDtype() { return py::dtype::of<T>(); }
+
+template <>
+py::dtype storageDtype<fpreal16>() { return py::dtype("float16"); }
+
+// Storage matching a numpy dtype, bool is read as uint8
+AttribStorage dtypeStorage(const py::dtype& dtype)
+{
+	const char kind = dtype.kind();
+	const auto size = dtype.itemsize();
+
+	if (kind == 'f' && size == 2) return AttribStorage::Real16;
+	if (kind == 'f' && size == 4) return AttribStorage::Real32;
+	if (kind == 'f' && size == 8) return AttribStorage::Real64;
+	if (kind == 'i' && size == 1) return AttribStorage::Int8;
+	if (kind == 'i' && size == 2) return AttribStorage::Int16;
+	if (kind == 'i' && size == 4) return AttribStorage::Int32;
+	if (kind == 'i' && size == 8) return AttribStorage::Int64;
+	if ((kind == 'u' || kind == 'b') && size == 1) return AttribStorage::UInt8;
+
+	throw std::runtime_error("Unsupported dtype");
+}
+
+// Casts dtypes dtypeStorage has no storage for: byte swapped arrays go to
+// native order, uint16 / uint32 to the next wider int and uint64 to float64
+py::array storageArray(const py::array& data)
+{
+	const py::dtype dtype = data.dtype();
+	const char kind = dtype.kind();
+	const auto size = dtype.itemsize();
+
+	if (kind == 'u' && size == 2) return data.attr("astype")("int32");
+	if (kind == 'u' && size == 4) return data.attr("astype")("int64");
+	if (kind == 'u' && size == 8) return data.attr("astype")("float64");
+	if (!dtype.attr("isnative").cast<bool>()) return data.attr("astype")(dtype.attr("newbyteorder")("="));
+
+	return data;
+}
+
+py::dict attribMemoryDict(const AttribMemory& mem)
+{
+	py::dict dict;
+	dict["name"] = mem.name;
+	dict["type"] = mem.type;
+	dict["storage"] = mem.storage;
+	dict["tuple_size"] = mem.tuple_size;
+	dict["bytes"] = mem.bytes;
+	dict["pages"] = mem.pages;
+	dict["constant_pages"] = mem.constant_pages;
+	dict["strings"] = mem.strings;
+	return dict;
+}
 
 PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 
@@ -37,6 +102,34 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 		.value("Invalid", AttribData::Invalid)
 		;
 
+	py::enum_<AttribStorage> attrstorage(m, "AttribStorage");
+	attrstorage
+		.value("UInt8", AttribStorage::UInt8)
+		.value("Int8", AttribStorage::Int8)
+		.value("Int16", AttribStorage::Int16)
+		.value("Int32", AttribStorage::Int32)
+		.value("Int64", AttribStorage::Int64)
+		.value("Real16", AttribStorage::Real16)
+		.value("Real32", AttribStorage::Real32)
+		.value("Real64", AttribStorage::Real64)
+		.value("String", AttribStorage::String)
+		.value("Invalid", AttribStorage::Invalid)
+		;
+
+	py::enum_<PromoteMethod> promote_method(m, "PromoteMethod");
+	promote_method
+		.value("Average", PromoteMethod::Average)
+		.value("First", PromoteMethod::First)
+		;
+
+	py::enum_<VolumeBorder> volume_border(m, "VolumeBorder");
+	volume_border
+		.value("Constant", VolumeBorder::Constant)
+		.value("Repeat", VolumeBorder::Repeat)
+		.value("Streak", VolumeBorder::Streak)
+		.value("SDF", VolumeBorder::SDF)
+		;
+
 	py::enum_<TypeInfo> typeinfo(m, "TypeInfo");
 	typeinfo
 		.value("Point", TypeInfo::Point)
@@ -91,13 +184,28 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 
 		.def("type", &Attrib::type)
 		.def("dataType", &Attrib::dataType)
+		.def("storage", &Attrib::storage)
+		.def("setStorage", &Attrib::setStorage)
+		.def("setTupleSize", &Attrib::setTupleSize)
 		.def("typeInfo", &Attrib::typeInfo)
 
-		.def("attribValue", [](const Attrib& self, Index offset = 0, Size size = -1) -> py::object
+		.def("attribValue", [](const Attrib& self, Index offset = 0, Size size = -1, bool native = false) -> py::object
 		{
 			if (size < 0)
 				size = self.size() - offset;
 
+			// Storage precision as is, e.g. float16 colors or int64 ids
+			if (native && self.dataType() != AttribData::String)
+			{
+				py::array arr;
+				visitStorage(self.storage(), [&](auto tag) {
+					using T = decltype(tag);
+					arr = py::array(storageDtype<T>(), std::vector<Size>{ size, self.tupleSize() });
+					self.attribValue<T>(arr.mutable_data(), offset, size);
+				});
+				return arr;
+			}
+
 			if (self.dataType() == AttribData::Float)
 			{
 				py::array_t<float> arr(std::vector<Size>{ size, self.tupleSize() });
@@ -127,42 +235,179 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 
 			return py::none();
 
-		}, py::arg("offset") = 0, py::arg("size") = -1)
-
-		.def("setAttribValue", [](Attrib& self, const py::array_t<float>& data, Index offset = 0, Size size = -1) {
-			auto tuple_size = data.shape()[1];
-
-			if (self.tupleSize() != tuple_size)
-				throw std::runtime_error("Tuple size mismatch");
+		}, py::arg("offset") = 0, py::arg("size") = -1, py::arg("native") = false)
 
+		.def("setAttribValue", [](Attrib& self, py::list data, Index offset = 0, Size size = -1) {
 			if (size < 0)
 				size = self.size() - offset;
 
-			self.setAttribValue<float>(data.data(), offset, size);
+			std::vector<std::string> arr;
+			for (int i = 0; i < data.size(); i++)
+				arr.push_back(py::cast<std::string>(data[i]));
+
+			self.setAttribValue<std::string>(arr.data(), offset, size);
 		}, py::arg("data"), py::arg("offset") = 0, py::arg("size") = -1)
 
-		.def("setAttribValue", [](Attrib& self, const py::array_t<float>& data, Index offset = 0, Size size = -1) {
-			auto tuple_size = data.shape()[1];
+		// Any numeric dtype and strided view (e.g. pts[:, :3]) is converted to
+		// the attribute's storage in one pass, missing components are set to `fill`.
+		// Byte swapped and uint16+ arrays are cast by storageArray first.
+		.def("setAttribValue", [](Attrib& self, const py::array& values, Index offset, Size size, double fill) {
+			const py::array data = storageArray(values);
+			if (data.ndim() > 2)
+				throw std::runtime_error("`data` must be 1 or 2 dimensional");
 
-			if (self.tupleSize() != tuple_size)
-				throw std::runtime_error("Tuple size mismatch");
+			const Size rows = data.ndim() > 0 ? data.shape(0) : 1;
+			const Size cols = data.ndim() > 1 ? data.shape(1) : 1;
 
 			if (size < 0)
-				size = self.size() - offset;
+				size = rows;
 
-			self.setAttribValue<int>(data.data(), offset, size);
-		}, py::arg("data"), py::arg("offset") = 0, py::arg("size") = -1)
+			if (size > rows)
+				throw std::runtime_error("Data size mismatch");
 
-		.def("setAttribValue", [](Attrib& self, py::list data, Index offset = 0, Size size = -1) {
+			const Index row_stride = data.ndim() > 0 ? data.strides(0) : 0;
+			const Index col_stride = data.ndim() > 1 ? data.strides(1) : data.itemsize();
+			const AttribStorage storage = dtypeStorage(data.dtype());
+
+			py::gil_scoped_release release;
+			self.setAttribValueStrided(data.data(), storage, size, cols, row_stride, col_stride, offset, fill);
+		}, py::arg("data"), py::arg("offset") = 0, py::arg("size") = -1, py::arg("fill") = 0.0)
+
+		.def("stringTable", [](const Attrib& self, Index offset, Size size) {
 			if (size < 0)
 				size = self.size() - offset;
 
-			std::vector<std::string> arr;
-			for (int i = 0; i < data.size(); i++)
-				arr.push_back(py::cast<std::string>(data[i]));
+			std::vector<std::string> table;
+			py::array_t<int> indices(std::vector<Size>{ size, self.tupleSize() });
+			int* out_data = indices.mutable_data();
+			{
+				py::gil_scoped_release release;
+				self.stringTable(table, out_data, offset, size);
+			}
 
-			self.setAttribValue<std::string>(arr.data(), offset, size);
-		}, py::arg("data"), py::arg("offset") = 0, py::arg("size") = -1)
+			return py::make_tuple(table, indices);
+		}, py::arg("offset") = 0, py::arg("size") = -1)
+
+		.def("setStringTable", [](Attrib& self, const std::vector<std::string>& table, const py::array_t<int, py::array::c_style | py::array::forcecast>& indices, Index offset) {
+			if (indices.size() % self.tupleSize() != 0)
+				throw std::runtime_error("Tuple size mismatch");
+
+			Size size = indices.size() / self.tupleSize();
+			const int* in_data = indices.data();
+			{
+				py::gil_scoped_release release;
+				self.setStringTable(table, in_data, offset, size);
+			}
+		}, py::arg("table"), py::arg("indices"), py::arg("offset") = 0)
+
+		// Tuples at arbitrary element indices, e.g. a selection from numpy
+		.def("gather", [](const Attrib& self, const py::array_t<Index, py::array::c_style | py::array::forcecast>& indices) -> py::array {
+			const Size count = indices.size();
+			const Index* in_indices = indices.data();
+			std::vector<Size> shape{ count, self.tupleSize() };
+
+			if (self.dataType() == AttribData::Float)
+			{
+				py::array_t<float> arr(shape);
+				float* out_data = arr.mutable_data();
+				{
+					py::gil_scoped_release release;
+					self.gatherValue<float>(in_indices, count, out_data);
+				}
+				return arr;
+			}
+			else if (self.storage() == AttribStorage::Int64)
+			{
+				py::array_t<int64> arr(shape);
+				int64* out_data = arr.mutable_data();
+				{
+					py::gil_scoped_release release;
+					self.gatherValue<int64>(in_indices, count, out_data);
+				}
+				return arr;
+			}
+			else if (self.dataType() == AttribData::Int)
+			{
+				py::array_t<int> arr(shape);
+				int* out_data = arr.mutable_data();
+				{
+					py::gil_scoped_release release;
+					self.gatherValue<int>(in_indices, count, out_data);
+				}
+				return arr;
+			}
+
+			throw std::runtime_error("Storage type mismatch");
+		}, py::arg("indices"))
+
+		// `indices` must be unique, duplicates are undefined behavior
+		.def("scatter", [](Attrib& self, const py::array_t<Index, py::array::c_style | py::array::forcecast>& indices, const py::array& data) {
+			const Size count = indices.size();
+			if (data.size() != count * self.tupleSize())
+				throw std::runtime_error("Data size mismatch");
+
+			const Index* in_indices = indices.data();
+
+			if (self.dataType() == AttribData::Float)
+			{
+				py::array_t<float, py::array::c_style | py::array::forcecast> values(data);
+				const float* in_data = values.data();
+				py::gil_scoped_release release;
+				self.scatterValue<float>(in_indices, count, in_data);
+			}
+			else if (self.storage() == AttribStorage::Int64)
+			{
+				py::array_t<int64, py::array::c_style | py::array::forcecast> values(data);
+				const int64* in_data = values.data();
+				py::gil_scoped_release release;
+				self.scatterValue<int64>(in_indices, count, in_data);
+			}
+			else if (self.dataType() == AttribData::Int)
+			{
+				py::array_t<int, py::array::c_style | py::array::forcecast> values(data);
+				const int* in_data = values.data();
+				py::gil_scoped_release release;
+				self.scatterValue<int>(in_indices, count, in_data);
+			}
+			else
+				throw std::runtime_error("Storage type mismatch");
+		}, py::arg("indices"), py::arg("data"))
+
+		.def("setAttribValueMasked", [](Attrib& self, const py::array_t<uint8_t, py::array::c_style | py::array::forcecast>& mask, const py::array& data, Index offset) {
+			const Size size = mask.size();
+			if (data.size() != size * self.tupleSize())
+				throw std::runtime_error("Data size mismatch");
+
+			const uint8_t* in_mask = mask.data();
+
+			if (self.dataType() == AttribData::Float)
+			{
+				py::array_t<float, py::array::c_style | py::array::forcecast> values(data);
+				const float* in_data = values.data();
+				py::gil_scoped_release release;
+				self.setAttribValueMasked<float>(in_mask, in_data, offset, size);
+			}
+			else if (self.storage() == AttribStorage::Int64)
+			{
+				py::array_t<int64, py::array::c_style | py::array::forcecast> values(data);
+				const int64* in_data = values.data();
+				py::gil_scoped_release release;
+				self.setAttribValueMasked<int64>(in_mask, in_data, offset, size);
+			}
+			else if (self.dataType() == AttribData::Int)
+			{
+				py::array_t<int, py::array::c_style | py::array::forcecast> values(data);
+				const int* in_data = values.data();
+				py::gil_scoped_release release;
+				self.setAttribValueMasked<int>(in_mask, in_data, offset, size);
+			}
+			else
+				throw std::runtime_error("Storage type mismatch");
+		}, py::arg("mask"), py::arg("data"), py::arg("offset") = 0)
+
+		.def("memoryUsage", [](const Attrib& self) {
+			return attribMemoryDict(self.memoryUsage());
+		})
 
 		;
 
@@ -234,10 +479,131 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 		.def("setIsClosed", &NURBSCurve::setIsClosed)
 		;
 
-	py::class_<Geometry> geometry(m, "Geometry");
+	py::class_<ElementRange> element_range(m, "ElementRange");
+	element_range
+		.def("__len__", &ElementRange::size)
+		.def("type", &ElementRange::type)
+		.def("isContiguous", &ElementRange::isContiguous)
+		.def("start", &ElementRange::start)
+		.def("indices", [](const ElementRange& self) {
+			return toArray<Index>(self.indices());
+		})
+		.def("attribValue", [](const ElementRange& self, const Attrib& attr) -> py::array {
+			std::vector<Size> shape{ self.size(), attr.tupleSize() };
+
+			if (attr.dataType() == AttribData::Float)
+			{
+				py::array_t<float> arr(shape);
+				self.attribValue<float>(attr, arr.mutable_data());
+				return arr;
+			}
+			else if (attr.dataType() == AttribData::Int)
+			{
+				py::array_t<int> arr(shape);
+				self.attribValue<int>(attr, arr.mutable_data());
+				return arr;
+			}
+
+			throw std::runtime_error("Storage type mismatch");
+		})
+		.def("setAttribValue", [](ElementRange& self, Attrib& attr, const py::array& data) {
+			if (data.size() != self.size() * attr.tupleSize())
+				throw std::runtime_error("Data size mismatch");
+
+			if (attr.dataType() == AttribData::Float)
+				self.setAttribValue<float>(attr, py::array_t<float, py::array::c_style | py::array::forcecast>(data).data());
+			else if (attr.dataType() == AttribData::Int)
+				self.setAttribValue<int>(attr, py::array_t<int, py::array::c_style | py::array::forcecast>(data).data());
+			else
+				throw std::runtime_error("Storage type mismatch");
+		})
+		;
+
+	py::class_<PointRange, ElementRange> point_range(m, "PointRange");
+	point_range
+		.def("__getitem__", [](const PointRange& self, Index i) {
+			if (i < 0)
+				i += self.size();
+			if (i < 0 || i >= self.size())
+				throw py::index_error();
+			return self[i];
+		})
+		.def("positions", [](const PointRange& self) {
+			py::array_t<float> arr(std::vector<Size>{ self.size(), 3 });
+			self.positions((Vector3*)arr.mutable_data());
+			return arr;
+		})
+		.def("setPositions", [](PointRange& self, const py::array_t<float, py::array::c_style | py::array::forcecast>& data) {
+			if (data.size() != self.size() * 3)
+				throw std::runtime_error("Data size mismatch");
+			self.setPositions((const Vector3*)data.data());
+		})
+		;
+
+	py::class_<PrimitiveRange, ElementRange> prim_range(m, "PrimitiveRange");
+	prim_range
+		.def("__getitem__", [](const PrimitiveRange& self, Index i) {
+			if (i < 0)
+				i += self.size();
+			if (i < 0 || i >= self.size())
+				throw py::index_error();
+			return self[i];
+		})
+		.def("vertexCounts", [](const PrimitiveRange& self) {
+			py::array_t<Size> arr(self.size());
+			self.vertexCounts(arr.mutable_data());
+			return arr;
+		})
+		.def("closedFlags", [](const PrimitiveRange& self) {
+			py::array_t<int> arr(self.size());
+			self.closedFlags(arr.mutable_data());
+			return arr;
+		})
+		.def("setClosedFlags", [](PrimitiveRange& self, const py::array_t<int, py::array::c_style | py::array::forcecast>& data) {
+			if (data.size() != self.size())
+				throw std::runtime_error("Data size mismatch");
+			self.setClosedFlags(data.data());
+		})
+		;
+
+	py::class_<Geometry, std::shared_ptr<Geometry>> geometry(m, "Geometry");
 	geometry
 		.def(py::init<>())
 		.def("clear", &Geometry::clear)
+		.def("recycle", &Geometry::recycle)
+
+		// Dict of byte counts, "attribs" lists Attrib.memoryUsage() dicts
+		.def("memoryUsage", [](const Geometry& self) {
+			const MemoryUsage mem = self.memoryUsage();
+
+			py::list attribs;
+			for (const auto& it : mem.attribs)
+				attribs.append(attribMemoryDict(it));
+
+			py::dict dict;
+			dict["attribs"] = attribs;
+			dict["attrib_bytes"] = mem.attrib_bytes;
+			dict["topology_bytes"] = mem.topology_bytes;
+			dict["index_map_bytes"] = mem.index_map_bytes;
+			dict["primitive_list_bytes"] = mem.primitive_list_bytes;
+			dict["other_bytes"] = mem.other_bytes;
+			dict["total_bytes"] = mem.total_bytes;
+			return dict;
+		})
+
+		.def_static("liveMemoryUsage", []() {
+			const LiveMemoryUsage mem = Geometry::liveMemoryUsage();
+
+			py::dict dict;
+			dict["geometries"] = mem.geometries;
+			dict["peak_geometries"] = mem.peak_geometries;
+			dict["total_bytes"] = mem.total_bytes;
+			dict["peak_bytes"] = mem.peak_bytes;
+			return dict;
+		})
+
+		.def("clone", &Geometry::clone, py::call_guard<py::gil_scoped_release>())
+		.def("copyFrom", &Geometry::copyFrom, py::call_guard<py::gil_scoped_release>())
         .def("reverse", &Geometry::reverse)
 		.def("getNumPoints", &Geometry::getNumPoints)
 		.def("getNumVertices", &Geometry::getNumVertices)
@@ -284,23 +650,112 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 				closed);
 		}, py::arg("positions"), py::arg("vertices"), py::arg("vertex_counts"), py::arg("closed") = true)
 
+		.def("createPolygonBlock", [](Geometry& self, const py::array_t<float, py::array::c_style | py::array::forcecast>& positions,
+			const py::array_t<Index, py::array::c_style | py::array::forcecast>& vertices,
+			const py::array_t<Size, py::array::c_style | py::array::forcecast>& vertex_counts, bool closed) {
+			if (positions.ndim() != 2 || positions.shape()[1] != 3)
+				throw std::runtime_error("`positions` shape must be (N, 3)");
+
+			Index first;
+			{
+				py::gil_scoped_release release;
+				first = self.createPolygonBlock(positions.shape()[0], (const Vector3*)positions.data(),
+					vertices.size(), vertices.data(),
+					vertex_counts.size(), vertex_counts.data(),
+					closed);
+			}
+
+			return self.primRange(first, vertex_counts.size());
+		}, py::arg("positions"), py::arg("vertices"), py::arg("vertex_counts"), py::arg("closed") = true,
+			py::keep_alive<0, 1>())
+
+		.def("pointRange", &Geometry::pointRange, py::arg("start") = 0, py::arg("count") = -1, py::keep_alive<0, 1>())
+		.def("pointSelection", &Geometry::pointSelection, py::arg("indices"), py::keep_alive<0, 1>())
+		.def("primRange", &Geometry::primRange, py::arg("start") = 0, py::arg("count") = -1, py::keep_alive<0, 1>())
+		.def("primSelection", &Geometry::primSelection, py::arg("indices"), py::keep_alive<0, 1>())
+		.def("createPointRange", [](Geometry& self, const py::array_t<float, py::array::c_style | py::array::forcecast>& positions) {
+			if (positions.ndim() != 2 || positions.shape()[1] != 3)
+				throw std::runtime_error("`positions` shape must be (N, 3)");
+
+			return self.createPointRange(positions.shape()[0], (const Vector3*)positions.data());
+		}, py::arg("positions"), py::keep_alive<0, 1>())
+
+		.def("createPolylines", [](Geometry& self, const py::array_t<Index, py::array::c_style | py::array::forcecast>& vertices,
+			const py::array_t<Size, py::array::c_style | py::array::forcecast>& vertex_counts) {
+			return self.createPolylines(vertices.size(), vertices.data(),
+				vertex_counts.size(), vertex_counts.data());
+		}, py::arg("vertices"), py::arg("vertex_counts"))
+
 		.def("createBezierCurve", &Geometry::createBezierCurve,
 			py::arg("num_vertices"), py::arg("is_closed") = false, py::arg("order") = 4)
 		.def("createNURBSCurve", &Geometry::createNURBSCurve,
 			py::arg("num_vertices"), py::arg("is_closed") = false, py::arg("order") = 4, py::arg("_interp_ends") = -1)
 
+		// Bezier `positions` are (N, 3, 3) arrays of (handle_left, anchor, handle_right)
+		.def("createCurves", [](Geometry& self, PrimitiveTypes type,
+			const py::array_t<float, py::array::c_style | py::array::forcecast>& positions,
+			const py::array_t<Size, py::array::c_style | py::array::forcecast>& counts,
+			const py::array_t<int, py::array::c_style | py::array::forcecast>& orders,
+			const py::array_t<int, py::array::c_style | py::array::forcecast>& closed,
+			py::object weights, py::object interp_ends) {
+			if (positions.shape(positions.ndim() - 1) != 3)
+				throw std::runtime_error("`positions` must end in 3 components");
+
+			if (orders.size() != counts.size() || closed.size() != counts.size())
+				throw std::runtime_error("`counts`, `orders` and `closed` size mismatch");
+
+			py::array_t<float, py::array::c_style | py::array::forcecast> w;
+			if (!weights.is_none())
+			{
+				w = weights.cast<py::array_t<float, py::array::c_style | py::array::forcecast>>();
+				if (w.size() * 3 != positions.size())
+					throw std::runtime_error("`weights` size mismatch");
+			}
+
+			py::array_t<int, py::array::c_style | py::array::forcecast> ends;
+			if (!interp_ends.is_none())
+			{
+				ends = interp_ends.cast<py::array_t<int, py::array::c_style | py::array::forcecast>>();
+				if (ends.size() != counts.size())
+					throw std::runtime_error("`interp_ends` size mismatch");
+			}
+
+			const float* w_data = weights.is_none() ? nullptr : w.data();
+			const int* ends_data = interp_ends.is_none() ? nullptr : ends.data();
+
+			py::gil_scoped_release release;
+			return self.createCurves(type, counts.size(), counts.data(), orders.data(), closed.data(),
+				positions.size() / 3, (const Vector3*)positions.data(), w_data, ends_data);
+		}, py::arg("type"), py::arg("positions"), py::arg("counts"), py::arg("orders"), py::arg("closed"),
+			py::arg("weights") = py::none(), py::arg("interp_ends") = py::none())
+
+		.def("weldPoints", &Geometry::weldPoints, py::arg("tolerance"), py::arg("average") = false,
+			py::call_guard<py::gil_scoped_release>())
+
+		// Returns (point_order, prim_order), the old index of each new element
+		.def("reorderForLocality", [](Geometry& self) {
+			std::vector<Index> point_order, prim_order;
+			{
+				py::gil_scoped_release release;
+				self.reorderForLocality(point_order, prim_order);
+			}
+			return py::make_tuple(toArray<Index>(point_order), toArray<Index>(prim_order));
+		})
+
 		.def("pointAttribs", &Geometry::pointAttribs)
 		.def("primAttribs", &Geometry::primAttribs)
 		.def("vertexAttribs", &Geometry::vertexAttribs)
 		.def("globalAttribs", &Geometry::globalAttribs)
 
-		.def("addFloatAttrib", [](Geometry& self, AttribType type, const std::string& name, const std::vector<float>& default_value, TypeInfo typeinfo) {
-			return self.addAttrib<float>(type, name, default_value, typeinfo);
-		}, py::return_value_policy::copy)
+		.def("addFloatAttrib", [](Geometry& self, AttribType type, const std::string& name, const std::vector<float>& default_value, TypeInfo typeinfo, AttribStorage storage) {
+			return self.addAttrib<float>(type, name, default_value, typeinfo, storage);
+		}, py::arg("type"), py::arg("name"), py::arg("default_value"), py::arg("typeinfo"), py::arg("storage") = AttribStorage::Real32,
+			py::return_value_policy::copy)
 
-		.def("addIntAttrib", [](Geometry& self, AttribType type, const std::string& name, const std::vector<int>& default_value, TypeInfo typeinfo) {
-			return self.addAttrib<int>(type, name, default_value, typeinfo);
-		}, py::return_value_policy::copy)
+		.def("addIntAttrib", [](Geometry& self, AttribType type, const std::string& name, const std::vector<int>& default_value, TypeInfo typeinfo, AttribStorage storage) {
+			return self.addAttrib<int>(type, name, default_value, typeinfo, storage);
+		}, py::arg("type"), py::arg("name"), py::arg("default_value"), py::arg("typeinfo"), py::arg("storage") = AttribStorage::Int32,
+			py::return_value_policy::copy)
 
 		.def("addStringAttrib", [](Geometry& self, AttribType type, const std::string& name, TypeInfo typeinfo) {
 			return self.addAttrib<std::string>(type, name, {""}, typeinfo);
@@ -330,13 +785,320 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 			return py::cast(attr);
 		}, py::return_value_policy::copy)
 
+		.def("cornerNormals", [](const Geometry& self, bool flip) {
+			py::array_t<float> arr(std::vector<Size>{ self.getNumVertices(), 3 });
+			Vector3* out_data = (Vector3*)arr.mutable_data();
+			{
+				py::gil_scoped_release release;
+				self.cornerNormals(out_data, flip);
+			}
+			return arr;
+		}, py::arg("flip") = false)
+
+		.def("curveData", [](const Geometry& self) {
+			CurveData data;
+			{
+				py::gil_scoped_release release;
+				self.curveData(data);
+			}
+
+			auto dict = py::dict();
+			dict["type"] = toArray<int>(data.type);
+			dict["order"] = toArray<int>(data.order);
+			dict["closed"] = toArray<int>(data.closed);
+			dict["endpoint"] = toArray<int>(data.endpoint);
+			dict["vertex_start"] = toArray<Index>(data.vertex_start);
+			dict["positions"] = toArray<float>(data.positions, 4);
+			dict["knot_start"] = toArray<Index>(data.knot_start);
+			dict["knots"] = toArray<float>(data.knots);
+			dict["anchor_start"] = toArray<Index>(data.anchor_start);
+			dict["anchors"] = toArray<float>(data.anchors, 3);
+			dict["handle_left"] = toArray<float>(data.handle_left, 3);
+			dict["handle_right"] = toArray<float>(data.handle_right, 3);
+			return dict;
+		})
+
+		.def("readAttribs", [](const Geometry& self, AttribType type, const std::vector<std::string>& selection, bool packed) {
+			std::vector<Attrib> attribs;
+
+			if (selection.empty())
+			{
+				for (const auto& attr : self.attribs(type))
+				{
+					if (attr.dataType() == AttribData::Float || attr.dataType() == AttribData::Int)
+						attribs.push_back(attr);
+				}
+			}
+			else
+			{
+				for (const auto& name : selection)
+				{
+					auto attr = self.findAttrib(type, name);
+					if (!attr)
+						throw std::runtime_error("Attribute not found: " + name);
+					attribs.push_back(attr);
+				}
+			}
+
+			// Packed layout places all arrays in one arena, each 64 byte aligned
+			py::array_t<uint8_t> arena;
+			if (packed)
+			{
+				Size total = 0;
+				for (const auto& attr : attribs)
+					total += (attr.size() * attr.tupleSize() * 4 + 63) & ~Size(63);
+				arena = py::array_t<uint8_t>(total + 64);
+			}
+
+			uint8_t* arena_ptr = packed ? (uint8_t*)(((uintptr_t)arena.mutable_data() + 63) & ~uintptr_t(63)) : nullptr;
+
+			py::dict result;
+			std::vector<void*> out_data;
+
+			for (const auto& attr : attribs)
+			{
+				std::vector<Size> shape{ attr.size(), attr.tupleSize() };
+				py::array arr;
+
+				if (attr.dataType() == AttribData::Float)
+					arr = packed ? py::array_t<float>(shape, (float*)arena_ptr, arena) : py::array_t<float>(shape);
+				else
+					arr = packed ? py::array_t<int>(shape, (int*)arena_ptr, arena) : py::array_t<int>(shape);
+
+				if (packed)
+					arena_ptr += (attr.size() * attr.tupleSize() * 4 + 63) & ~Size(63);
+
+				out_data.push_back(arr.mutable_data());
+				result[py::str(attr.name())] = arr;
+			}
+
+			{
+				py::gil_scoped_release release;
+				self.readAttribs(attribs, out_data);
+			}
+
+			return result;
+		}, py::arg("type"), py::arg("selection") = std::vector<std::string>(), py::arg("packed") = false)
+		.def("isPointCloud", &Geometry::isPointCloud)
+		.def("particlePoints", [](const Geometry& self) {
+			std::vector<Index> points;
+			self.particlePoints(points);
+			return toArray<Index>(points);
+		})
+		// Point positions and attributes of particle points (or all points)
+		// without any topology, `selection` defaults to every float/int attribute
+		.def("pointCloud", [](const Geometry& self, const std::vector<std::string>& selection) {
+			std::vector<Attrib> attribs;
+
+			for (const auto& attr : self.pointAttribs())
+			{
+				if (attr.dataType() != AttribData::Float && attr.dataType() != AttribData::Int)
+					continue;
+
+				if (selection.empty() || attr.name() == "P"
+					|| std::find(selection.begin(), selection.end(), attr.name()) != selection.end())
+					attribs.push_back(attr);
+			}
+
+			std::vector<Index> points;
+			{
+				py::gil_scoped_release release;
+				self.particlePoints(points);
+			}
+
+			py::dict result;
+			std::vector<void*> out_data;
+
+			for (const auto& attr : attribs)
+			{
+				std::vector<Size> shape{ (Size)points.size(), attr.tupleSize() };
+				py::array arr;
+
+				if (attr.dataType() == AttribData::Float)
+					arr = py::array_t<float>(shape);
+				else
+					arr = py::array_t<int>(shape);
+
+				out_data.push_back(arr.mutable_data());
+				result[py::str(attr.name())] = arr;
+			}
+
+			{
+				py::gil_scoped_release release;
+				self.readPointAttribs(attribs, points, out_data);
+			}
+
+			return result;
+		}, py::arg("selection") = std::vector<std::string>())
+
+		.def("promoteAttribValue", [](const Geometry& self, const Attrib& attr, AttribType dst_type, PromoteMethod method) {
+			py::array_t<float> arr(std::vector<Size>{ self.elementCount(dst_type), attr.tupleSize() });
+			float* out_data = arr.mutable_data();
+			{
+				py::gil_scoped_release release;
+				self.promoteAttribValue(attr, dst_type, out_data, method);
+			}
+			return arr;
+		}, py::arg("attr"), py::arg("dst_type"), py::arg("method") = PromoteMethod::Average)
+
+		.def("promoteAttrib", [](Geometry& self, const Attrib& attr, AttribType dst_type, const std::string& name, PromoteMethod method) {
+			py::gil_scoped_release release;
+			return self.promoteAttrib(attr, dst_type, name, method);
+		}, py::arg("attr"), py::arg("dst_type"), py::arg("name"), py::arg("method") = PromoteMethod::Average,
+			py::return_value_policy::copy)
+
+		.def("triangulate", [](const Geometry& self) {
+			Triangles tris;
+			{
+				py::gil_scoped_release release;
+				self.triangulate(tris);
+			}
+
+			auto dict = py::dict();
+			dict["points"] = toArray<Index>(tris.points, 3);
+			dict["vertices"] = toArray<Index>(tris.vertices, 3);
+			dict["prims"] = toArray<Index>(tris.prims);
+			return dict;
+		})
+
+		.def("meshQuads", [](const Geometry& self) {
+			MeshQuads quads;
+			{
+				py::gil_scoped_release release;
+				self.meshQuads(quads);
+			}
+
+			auto dict = py::dict();
+			dict["points"] = toArray<Index>(quads.points, 4);
+			dict["vertices"] = toArray<Index>(quads.vertices, 4);
+			dict["prims"] = toArray<Index>(quads.prims);
+			return dict;
+		})
+		.def("groupNames", &Geometry::groupNames)
+		.def("groupMasks", [](const Geometry& self, AttribType type, py::object names) {
+			std::vector<std::string> group_names = names.is_none()
+				? self.groupNames(type) : names.cast<std::vector<std::string>>();
+
+			const Size num_bytes = (self.elementCount(type) + 7) / 8;
+
+			std::vector<py::array_t<uint8_t>> arrays;
+			std::vector<uint8_t*> ptrs;
+			for (size_t i = 0; i < group_names.size(); i++)
+			{
+				arrays.emplace_back(num_bytes);
+				ptrs.push_back(arrays.back().mutable_data());
+			}
+
+			{
+				py::gil_scoped_release release;
+				self.groupMasks(type, group_names, ptrs);
+			}
+
+			auto dict = py::dict();
+			for (size_t i = 0; i < group_names.size(); i++)
+				dict[py::str(group_names[i])] = arrays[i];
+			return dict;
+		}, py::arg("type"), py::arg("names") = py::none())
+		.def("groupIndices", [](const Geometry& self, AttribType type, py::object names) {
+			std::vector<std::string> group_names = names.is_none()
+				? self.groupNames(type) : names.cast<std::vector<std::string>>();
+
+			std::vector<std::vector<Index>> indices;
+			{
+				py::gil_scoped_release release;
+				self.groupIndices(type, group_names, indices);
+			}
+
+			auto dict = py::dict();
+			for (size_t i = 0; i < group_names.size(); i++)
+				dict[py::str(group_names[i])] = toArray<Index>(indices[i]);
+			return dict;
+		}, py::arg("type"), py::arg("names") = py::none())
+		.def("edges", [](const Geometry& self) {
+			Edges edges;
+			{
+				py::gil_scoped_release release;
+				self.edges(edges);
+			}
+
+			auto dict = py::dict();
+			dict["edges"] = toArray<Index>(edges.edges, 2);
+			dict["corner_edge"] = toArray<Index>(edges.corner_edge);
+			return dict;
+		})
+		.def("volumes", [](const Geometry& self, int stride) {
+			std::vector<VolumeInfo> infos;
+			self.volumeInfos(infos, stride);
+
+			py::list result;
+			std::vector<Index> prims;
+			std::vector<float*> out_data;
+
+			for (const auto& info : infos)
+			{
+				py::array_t<float> voxels(std::vector<Size>{ info.resolution[0], info.resolution[1], info.resolution[2] });
+
+				prims.push_back(info.prim);
+				out_data.push_back(voxels.mutable_data());
+
+				auto dict = py::dict();
+				dict["prim"] = info.prim;
+				dict["name"] = info.name;
+				dict["resolution"] = std::vector<int>(info.resolution, info.resolution + 3);
+				dict["transform"] = py::array_t<float>(std::vector<Size>{ 4, 4 }, info.transform.data());
+				dict["border"] = info.border;
+				dict["border_value"] = info.border_value;
+				dict["voxels"] = voxels;
+				result.append(dict);
+			}
+
+			{
+				py::gil_scoped_release release;
+				self.readVolumes(prims, out_data, stride);
+			}
+
+			return result;
+		}, py::arg("stride") = 1)
+		.def("packedInstances", [](const Geometry& self) {
+			PackedInstances instances;
+			{
+				py::gil_scoped_release release;
+				self.packedInstances(instances);
+			}
+
+			auto dict = py::dict();
+			dict["prims"] = toArray<Index>(instances.prims);
+			dict["transforms"] = py::array_t<float>(std::vector<Size>{ (Size)instances.transforms.size(), 4, 4 },
+				(const float*)instances.transforms.data());
+			dict["prototype"] = toArray<Index>(instances.prototype);
+			dict["paths"] = instances.paths;
+			dict["prototypes"] = instances.prototypes;
+			return dict;
+		})
+
+		.def("setStoragePolicy", py::overload_cast<const std::string&, AttribStorage, Size>(&Geometry::setStoragePolicy),
+			py::arg("name"), py::arg("storage"), py::arg("tuple_size") = -1)
+		.def("setStoragePolicy", py::overload_cast<TypeInfo, AttribStorage, Size>(&Geometry::setStoragePolicy),
+			py::arg("typeinfo"), py::arg("storage"), py::arg("tuple_size") = -1)
+		.def("clearStoragePolicies", &Geometry::clearStoragePolicies)
+		.def("applyStoragePolicies", [](Geometry& self) {
+			py::gil_scoped_release release;
+			self.applyStoragePolicies();
+		})
+
         .def("filterPrimitiveByType", &Geometry::filterPrimitiveByType)
     
 		.def("load", &Geometry::load)
-		.def("save", &Geometry::save)
+
+		// Call after load() with e.g. the previous frame, returns the shared Attribs
+		.def("shareAttribs", &Geometry::shareAttribs, py::arg("other"), py::call_guard<py::gil_scoped_release>())
+		.def("save", &Geometry::save, py::call_guard<py::gil_scoped_release>())
 
 		.def("_dataByType", [](Geometry& self, std::vector<PrimitiveTypes> filter_prim_types) {
             self.filterPrimitiveByType(filter_prim_types);
+
+			// the arrays below are index based, removed points and prims leave holes
+			self.geo().defragment();
 		    
 			auto dict = py::dict();
 
@@ -381,6 +1143,12 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
                     closed.emplace_back(p.isClosed());
                     _prims.append(prim);
                 }
+			    else
+			    {
+			        // surfaces (e.g. meshes) count as closed, keeps the arrays aligned
+			        closed.emplace_back(1);
+			        _prims.append(prim);
+			    }
 			}
 
 			dict["prims"] = _prims;
@@ -393,4 +1161,154 @@ PYBIND11_MODULE(CMAKE_PYMODULE_NAME, m) {
 		    return dict;
 		})
 	;
+
+	py::class_<GeometryPool>(m, "GeometryPool")
+		.def(py::init<>())
+		.def("acquire", &GeometryPool::acquire, py::arg("key"))
+		.def("release", &GeometryPool::release, py::arg("key"))
+		.def("clear", &GeometryPool::clear)
+		.def("__len__", &GeometryPool::size)
+		.def("keys", &GeometryPool::keys)
+		;
+
+	// arrays: positions (N, 3), loop_points, loop_totals, optional loose_edges (E, 2),
+	// "point", "corner" and "face" dicts of name -> (array, TypeInfo) and a
+	// "face_strings" dict of name -> (table, indices).
+	// options: "storage_policies" dict of TypeInfo -> (AttribStorage, tuple_size)
+	// and optional "weld_tolerance" / "weld_average" (see Geometry.weldPoints) and
+	// "reorder" (see Geometry.reorderForLocality)
+	m.def("exportMesh", [](const std::string& path, const py::dict& arrays, const py::dict& options) {
+		using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+		using IndexArray = py::array_t<Index, py::array::c_style | py::array::forcecast>;
+		using IntArray = py::array_t<int, py::array::c_style | py::array::forcecast>;
+		using Int64Array = py::array_t<int64, py::array::c_style | py::array::forcecast>;
+
+		// converted arrays stay alive until the export is done
+		std::vector<py::array> keep;
+
+		MeshArrays mesh;
+
+		FloatArray positions = arrays["positions"].cast<FloatArray>();
+		if (positions.ndim() != 2 || positions.shape(1) != 3)
+			throw std::runtime_error("`positions` shape must be (N, 3)");
+
+		IndexArray loop_points = arrays["loop_points"].cast<IndexArray>();
+		IndexArray loop_totals = arrays["loop_totals"].cast<IndexArray>();
+		keep.insert(keep.end(), { positions, loop_points, loop_totals });
+
+		mesh.num_points = positions.shape(0);
+		mesh.positions = (const Vector3*)positions.data();
+		mesh.num_loops = loop_points.size();
+		mesh.loop_points = loop_points.data();
+		mesh.num_faces = loop_totals.size();
+		mesh.loop_totals = loop_totals.data();
+
+		if (arrays.contains("loose_edges"))
+		{
+			IndexArray edges = arrays["loose_edges"].cast<IndexArray>();
+			if (edges.size() > 0 && (edges.ndim() != 2 || edges.shape(1) != 2))
+				throw std::runtime_error("`loose_edges` shape must be (E, 2)");
+
+			keep.push_back(edges);
+
+			mesh.num_loose_edges = edges.size() / 2;
+			mesh.loose_edges = edges.data();
+		}
+
+		const std::vector<std::pair<const char*, AttribType>> domains = {
+			{ "point", AttribType::Point },
+			{ "corner", AttribType::Vertex },
+			{ "face", AttribType::Prim },
+		};
+
+		for (const auto& domain : domains)
+		{
+			if (!arrays.contains(domain.first))
+				continue;
+
+			for (const auto& item : arrays[domain.first].cast<py::dict>())
+			{
+				py::tuple value = item.second.cast<py::tuple>();
+				py::array data = value[0].cast<py::array>();
+
+				MeshLayer layer;
+				layer.name = item.first.cast<std::string>();
+				layer.type = domain.second;
+				layer.typeinfo = value[1].cast<TypeInfo>();
+				layer.size = data.ndim() > 0 ? data.shape(0) : 0;
+				layer.tuple_size = data.ndim() > 1 ? data.shape(1) : 1;
+
+				if (data.ndim() > 2)
+					throw std::runtime_error("Layer `" + layer.name + "` must be 1 or 2 dimensional");
+
+				const char kind = data.dtype().kind();
+				if (kind == 'u' && data.itemsize() > 4)
+					throw std::runtime_error("Layer `" + layer.name + "`: uint64 data is not supported");
+
+				// int64 and uint32 need 64 bit storage to keep their values
+				if ((kind == 'i' && data.itemsize() > 4) || (kind == 'u' && data.itemsize() == 4))
+				{
+					Int64Array arr = data.cast<Int64Array>();
+					layer.data_type = AttribData::Int;
+					layer.storage = AttribStorage::Int64;
+					layer.data = arr.data();
+					keep.push_back(arr);
+				}
+				else if (kind == 'i' || kind == 'u')
+				{
+					IntArray arr = data.cast<IntArray>();
+					layer.data_type = AttribData::Int;
+					layer.data = arr.data();
+					keep.push_back(arr);
+				}
+				else
+				{
+					FloatArray arr = data.cast<FloatArray>();
+					layer.data_type = AttribData::Float;
+					layer.data = arr.data();
+					keep.push_back(arr);
+				}
+
+				mesh.layers.push_back(layer);
+			}
+		}
+
+		if (arrays.contains("face_strings"))
+		{
+			for (const auto& item : arrays["face_strings"].cast<py::dict>())
+			{
+				py::tuple value = item.second.cast<py::tuple>();
+				IntArray indices = value[1].cast<IntArray>();
+				keep.push_back(indices);
+
+				MeshStringLayer layer;
+				layer.name = item.first.cast<std::string>();
+				layer.type = AttribType::Prim;
+				layer.table = value[0].cast<std::vector<std::string>>();
+				layer.size = indices.size();
+				layer.indices = indices.data();
+				mesh.string_layers.push_back(layer);
+			}
+		}
+
+		MeshExportOptions opts;
+		if (options.contains("storage_policies"))
+		{
+			for (const auto& item : options["storage_policies"].cast<py::dict>())
+			{
+				py::tuple value = item.second.cast<py::tuple>();
+				opts.typeinfo_policies[item.first.cast<TypeInfo>()] = { value[0].cast<AttribStorage>(), value[1].cast<Size>() };
+			}
+		}
+
+		if (options.contains("weld_tolerance"))
+			opts.weld_tolerance = options["weld_tolerance"].cast<float>();
+		if (options.contains("weld_average"))
+			opts.weld_average = options["weld_average"].cast<bool>();
+		if (options.contains("reorder"))
+			opts.reorder = options["reorder"].cast<bool>();
+
+		py::gil_scoped_release release;
+		return exportMesh(path, mesh, opts);
+	}, py::arg("path"), py::arg("arrays"), py::arg("options") = py::dict());
 }
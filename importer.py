@@ -12,18 +12,100 @@ from bpy_extras.io_utils import axis_conversion
 from bpy_extras.io_utils import unpack_list
 
 
+def read_attribs(geo: hio.Geometry, type, attribs, skip=()):
+    # Reads all numeric attributes of one class in a single parallel call
+    names = [
+        x.name()
+        for x in attribs
+        if x.dataType() in (hio.AttribData.Int, hio.AttribData.Float)
+        and x.name() not in skip
+    ]
+
+    if not names:
+        return {}
+
+    return geo.readAttribs(type, names)
+
+
 def import_mesh(geo: hio.Geometry, name: str, opts: dict):
     me = bpy.data.meshes.new(name)
 
-    pdata = geo._dataByType([hio.PrimitiveTypes.Poly])
+    # Only polygons and meshes become faces, other primitives and the points
+    # they leave unused are removed before the vertices are created
+    pdata = geo._dataByType([hio.PrimitiveTypes.Poly, hio.PrimitiveTypes.Mesh])
 
     me.vertices.add(geo.getNumPoints())
     me.vertices.foreach_set("co", geo.points().flatten())
 
-    vertex_indices = pdata["vertices"]
-    loop_start = pdata["vertex_start_index"]
-    loop_total = pdata["vertex_count"]
-    closed = pdata["closed"]
+    vertex_indices = np.asarray(pdata["vertices"])
+    loop_start = np.asarray(pdata["vertex_start_index"])
+    loop_total = np.asarray(pdata["vertex_count"])
+    closed = np.asarray(pdata["closed"], dtype=bool)
+    is_poly = np.asarray(pdata["type"]) == int(hio.PrimitiveTypes.Poly)
+
+    # Edges are precomputed so Blender does not rebuild them, open
+    # polygons only contribute loose edges
+    edata = geo.edges()
+    edges = edata["edges"]
+    corner_edge = edata["corner_edge"]
+    loop_edge = corner_edge
+
+    has_loose_edges = not closed[is_poly].all()
+
+    # Mesh (grid) primitives are split into quads and open polygons are
+    # dropped, loops then no longer map 1:1 to vertices and faces to prims
+    corner_vertex = None
+    face_prim = None
+
+    mdata = geo.meshQuads()
+    num_quads = len(mdata["prims"])
+
+    if has_loose_edges or num_quads:
+        face_prim = np.flatnonzero(is_poly & closed)
+
+        # start of every prim in `vertex_indices`
+        packed_start = np.cumsum(loop_total) - loop_total
+
+        starts = loop_start[face_prim]
+        packed = packed_start[face_prim]
+        loop_total = loop_total[face_prim]
+
+        loop_start = np.zeros(len(loop_total), dtype=np.int64)
+        np.cumsum(loop_total[:-1], out=loop_start[1:])
+
+        local = np.arange(loop_total.sum()) - np.repeat(loop_start, loop_total)
+        corner_vertex = np.repeat(starts, loop_total) + local
+        vertex_indices = vertex_indices[np.repeat(packed, loop_total) + local]
+        loop_edge = corner_edge[corner_vertex]
+
+    if num_quads:
+        quads = mdata["points"]
+
+        # quads follow the polygons, every face/corner keeps its source prim/vertex
+        loop_start = np.concatenate([loop_start, len(vertex_indices) + np.arange(0, num_quads * 4, 4)])
+        loop_total = np.concatenate([loop_total, np.full(num_quads, 4)])
+        face_prim = np.concatenate([face_prim, mdata["prims"]])
+        corner_vertex = np.concatenate([corner_vertex, mdata["vertices"].ravel()])
+        vertex_indices = np.concatenate([vertex_indices, quads.ravel()])
+
+        # quad edges are merged into the polygon edges
+        a = quads.ravel()
+        b = np.roll(quads, -1, axis=1).ravel()
+        quad_edges = np.column_stack((np.minimum(a, b), np.maximum(a, b)))
+
+        edges, inverse = np.unique(
+            np.concatenate([np.asarray(edges).reshape(-1, 2), quad_edges]), axis=0, return_inverse=True
+        )
+        inverse = inverse.ravel()
+
+        num_poly_edges = len(inverse) - len(quad_edges)
+        loop_edge = np.concatenate([inverse[:num_poly_edges][loop_edge], inverse[num_poly_edges:]])
+
+    def to_corners(data):
+        return data if corner_vertex is None else data[corner_vertex]
+
+    def to_faces(data):
+        return data if face_prim is None else data[face_prim]
 
     ###
 
@@ -33,12 +115,28 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
     me.polygons.add(len(loop_start))
     me.polygons.foreach_set("loop_start", loop_start)
     me.polygons.foreach_set("loop_total", loop_total)
+
+    me.edges.add(len(edges))
+    me.edges.foreach_set("vertices", edges.ravel())
+    me.loops.foreach_set("edge_index", loop_edge)
     
     ###
 
     skip_normals = opts['skip_normals']
 
+    # Custom normals (vertex N, or point N promoted to corners)
+    if not skip_normals and (geo.findVertexAttrib("N") or geo.findPointAttrib("N")):
+        me.create_normals_split()
+        me.validate(clean_customdata=False)
+        me.polygons.foreach_set("use_smooth", np.ones(len(me.polygons), dtype=bool))
+
+        # flipped here, the winding is flipped by me.flip_normals() below
+        me.normals_split_custom_set(to_corners(geo.cornerNormals(flip=True)))
+        me.use_auto_smooth = True
+
     # Vertex attributes
+    values = read_attribs(geo, hio.AttribType.Vertex, geo.vertexAttribs(), skip=("N",))
+
     for attr in geo.vertexAttribs():
         # print('vertex', attr.name(), attr.typeInfo())
 
@@ -47,31 +145,12 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
             # print("Unsupported attribute data type: ", attr.dataType())
             continue
 
-        # Vertex normals
+        # Vertex normals are handled by cornerNormals()
         if attr.name() == "N":
-            if skip_normals:
-                continue
-
-            me.create_normals_split()
-
-            me.validate(clean_customdata=False)
-
-            me.polygons.foreach_set("use_smooth", np.ones(len(me.polygons), dtype=np.bool))
-
-            data = attr.attribValue()
-            data = data.flatten()
-            data *= -1
-
-            data = tuple(zip(*(iter(data),) * 3))
-
-            # TODO: This function is slow, need to look for other way
-            me.normals_split_custom_set(data)
-
-            me.use_auto_smooth = True
             continue
 
         if attr.name() == "uv":
-            data = attr.attribValue()
+            data = to_corners(values[attr.name()])
             data = data[:, :2]
             data = data.flatten()
 
@@ -79,7 +158,7 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
             uv_layer.data.foreach_set("uv", data)
             continue
 
-        data = attr.attribValue()
+        data = to_corners(values[attr.name()])
         b_type = None
 
         if attr.typeInfo() == hio.TypeInfo.Value:
@@ -113,6 +192,8 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
     ###
     
     # Point attributes
+    values = read_attribs(geo, hio.AttribType.Point, geo.pointAttribs(), skip=("P", "N", "uv"))
+
     for attr in geo.pointAttribs():
         # print('point', attr.name(), attr.typeInfo())
 
@@ -125,25 +206,24 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
         if attr.typeInfo() == hio.TypeInfo.Point and attr.name() == "P":
             continue
         
-        # Point normals
+        # Point normals are handled by cornerNormals()
         if attr.name() == "N":
-            if skip_normals:
-                continue
+            continue
 
-            me.create_normals_split()
-            me.validate(clean_customdata=False)
-            me.polygons.foreach_set("use_smooth", np.ones(len(me.polygons), dtype=np.bool))
+        # Blender keeps uvs on corners, gather point uvs onto vertices
+        if attr.name() == "uv":
+            if geo.findVertexAttrib("uv"):
+                continue
 
-            data = attr.attribValue()
+            data = to_corners(geo.promoteAttribValue(attr, hio.AttribType.Vertex))
+            data = data[:, :2]
             data = data.flatten()
-            data *= -1
 
-            data = tuple(zip(*(iter(data),) * 3))
-            me.normals_split_custom_set_from_vertices(data)
-            me.use_auto_smooth = True
+            uv_layer = me.uv_layers.new(name=attr.name())
+            uv_layer.data.foreach_set("uv", data)
             continue
 
-        data = attr.attribValue()
+        data = values[attr.name()]
         b_type = None
 
         if attr.typeInfo() == hio.TypeInfo.Value:
@@ -177,21 +257,33 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
     ###
     
     # Prim attributes
+    values = read_attribs(geo, hio.AttribType.Prim, geo.primAttribs())
+
     for attr in geo.primAttribs():
         # print('prim', attr.name(), attr.typeInfo(), attr.dataType())
 
+        # String attributes become an INT face attribute of string table
+        # indices, the table itself is stored as a custom property
+        if attr.dataType() == hio.AttribData.String and attr.tupleSize() == 1:
+            table, indices = attr.stringTable()
+
+            ma = me.attributes.new(name=attr.name(), type="INT", domain="FACE")
+            ma.data.foreach_set("value", to_faces(indices.ravel()))
+            me[attr.name()] = table
+            continue
+
         if not (attr.dataType() == hio.AttribData.Int
                 or attr.dataType() == hio.AttribData.Float):
             # print("Unsupported attribute data type: ", attr.dataType())
             continue
 
         if attr.name() == "material_index":
-            data = attr.attribValue()
+            data = to_faces(values[attr.name()])
             data = data.flatten()
             me.polygons.foreach_set("material_index", data)
             continue
         
-        data = attr.attribValue()
+        data = to_faces(values[attr.name()])
         b_type = None
 
         if attr.typeInfo() == hio.TypeInfo.Value:
@@ -217,106 +309,176 @@ def import_mesh(geo: hio.Geometry, name: str, opts: dict):
         ma.data.foreach_set(key, data)
 
     ###
+
+    # Groups become BOOLEAN attributes, names already taken by attributes are skipped
+    for type, domain, to_domain in ((hio.AttribType.Point, "POINT", lambda x: x),
+                                    (hio.AttribType.Prim, "FACE", to_faces)):
+        count = geo.getNumPoints() if type == hio.AttribType.Point else geo.getNumPrimitives()
+
+        for name, mask in geo.groupMasks(type).items():
+            if name in me.attributes:
+                continue
+
+            data = np.unpackbits(mask, count=count, bitorder="little").astype(bool)
+
+            ma = me.attributes.new(name=name, type="BOOLEAN", domain=domain)
+            ma.data.foreach_set("value", to_domain(data))
+
+    ###
     
     me.flip_normals()
+    me.update(calc_edges_loose=has_loose_edges)
+
+    return me
+
+
+def import_points(geo: hio.Geometry, name: str, opts: dict):
+    # Point clouds and particles skip the topology, only loose vertices
+    # with point attributes are created
+    me = bpy.data.meshes.new(name)
+
+    values = geo.pointCloud()
+    P = values.pop("P")
+
+    me.vertices.add(len(P))
+    me.vertices.foreach_set("co", P.ravel())
+
+    for attr in geo.pointAttribs():
+        if attr.name() not in values:
+            continue
+
+        data = values[attr.name()]
+        tuple_size = data.shape[1]
+
+        if attr.dataType() == hio.AttribData.Int and tuple_size == 1:
+            b_type = "INT"
+            key = "value"
+
+        elif tuple_size == 1:
+            b_type = "FLOAT"
+            key = "value"
+
+        elif attr.typeInfo() == hio.TypeInfo.Color and tuple_size in (3, 4):
+            b_type = "FLOAT_COLOR"
+            key = "color"
+            if tuple_size == 3:
+                data = np.column_stack((data, np.ones(data.shape[0], dtype=data.dtype)))
+
+        elif tuple_size == 3:
+            b_type = "FLOAT_VECTOR"
+            key = "vector"
+
+        elif tuple_size == 2:
+            b_type = "FLOAT2"
+            key = "vector"
+
+        else:
+            print("Unsupported attribute type: ", attr.typeInfo())
+            continue
+
+        ma = me.attributes.new(name=attr.name(), type=b_type, domain="POINT")
+        ma.data.foreach_set(key, data.ravel())
+
     me.update()
 
     return me
 
 
+def assign_materials(me):
+    # Map `shop_materialpath` entries to material slots by material name
+    attr = me.attributes.get("shop_materialpath")
+    if attr is None or "material_index" in me.attributes:
+        return
+
+    slots = {m.name: i for i, m in enumerate(me.materials) if m}
+    table = [os.path.basename(x) for x in me["shop_materialpath"]]
+
+    # the trailing entry catches empty strings (index -1)
+    remap = np.array([slots.get(x, 0) for x in table] + [0], dtype=np.int32)
+
+    indices = np.empty(len(me.polygons), dtype=np.int32)
+    attr.data.foreach_get("value", indices)
+    me.polygons.foreach_set("material_index", remap[indices])
+
+
 def import_curve(geo: hio.Geometry, name: str, opts: dict):
     cu = bpy.data.curves.new(name, type="CURVE")
     cu.dimensions = "3D"
     cu.fill_mode = "FULL"
 
-    target_type = [hio.PrimitiveTypes.NURBSCurve, hio.PrimitiveTypes.BezierCurve]
-    pdata = geo._dataByType(target_type)
-
-    points = geo.points()
+    cdata = geo.curveData()
 
-    vertex_indices = pdata["vertices"]
-    prim_types = pdata["type"]
-    vertex_count = pdata["vertex_count"]
-    vertex_start_index = pdata["vertex_start_index"]
-    closed = pdata["closed"]
+    vertex_start = cdata["vertex_start"]
+    anchor_start = cdata["anchor_start"]
+    positions = cdata["positions"]
+    anchors = cdata["anchors"]
+    handle_left = cdata["handle_left"]
+    handle_right = cdata["handle_right"]
 
-    for i, prim_type in enumerate(prim_types):
+    for i, prim_type in enumerate(cdata["type"]):
         t = hio.PrimitiveTypes(prim_type)
 
         if t == hio.PrimitiveTypes.NURBSCurve:
             sp = cu.splines.new("NURBS")
-            
-            N = vertex_count[i]
-            sp.points.add(N - 1)
 
-            idxs = list(range(vertex_start_index[i], vertex_start_index[i] + N))
-            idxs = np.take(vertex_indices, idxs)
+            s, e = vertex_start[i], vertex_start[i + 1]
+            sp.points.add(e - s - 1)
+            sp.points.foreach_set("co", positions[s:e].ravel())
 
-            pos = np.take(points, idxs, axis=0)
-            pos = np.column_stack((pos, np.ones((N, 1))))
-            pos = pos.flatten()
-
-            sp.points.foreach_set("co", pos)
-            sp.use_cyclic_u = closed[i]
-            sp.use_endpoint_u = not closed[i]
-            sp.order_u = 4
+            sp.use_cyclic_u = bool(cdata["closed"][i])
+            sp.use_endpoint_u = bool(cdata["endpoint"][i])
+            sp.order_u = cdata["order"][i]
 
         elif t == hio.PrimitiveTypes.BezierCurve:
             sp = cu.splines.new("BEZIER")
 
-            N = int((vertex_count[i] + 2) / 3)
-            sp.bezier_points.add(N - 1)
-
-            idxs = list(
-                range(vertex_start_index[i], vertex_start_index[i] + vertex_count[i])
-            )
-            idxs = np.take(vertex_indices, idxs)
-
-            pos = np.take(points, idxs, axis=0)
-
-            if closed[i]:
-                for n in range(N):
-                    pt = sp.bezier_points[n]
-                    pt.handle_left = pos[n * 3 - 1]
-                    pt.co = pos[n * 3]
-                    pt.handle_right = pos[n * 3 + 1]
-
-            else:
-                for n in range(N):
-                    pt = sp.bezier_points[n]
-                    if n == 0:
-                        pt.handle_left = pos[0]
-                        pt.co = pos[0]
-                        pt.handle_right = pos[1]
-                    elif n == N - 1:
-                        pt.handle_left = pos[n * 3 - 1]
-                        pt.co = pos[n * 3]
-                        pt.handle_right = pos[n * 3]
-                    else:
-                        pt.handle_left = pos[n * 3 - 1]
-                        pt.co = pos[n * 3]
-                        pt.handle_right = pos[n * 3 + 1]
-
-            sp.use_cyclic_u = closed[i]
+            s, e = anchor_start[i], anchor_start[i + 1]
+            sp.bezier_points.add(e - s - 1)
+            sp.bezier_points.foreach_set("co", anchors[s:e].ravel())
+            sp.bezier_points.foreach_set("handle_left", handle_left[s:e].ravel())
+            sp.bezier_points.foreach_set("handle_right", handle_right[s:e].ravel())
+
+            sp.use_cyclic_u = bool(cdata["closed"][i])
             sp.use_endpoint_u = True
-            sp.order_u = 4
+            sp.order_u = cdata["order"][i]
 
     return cu
 
 
+# Sequences keep one recycled detail per object between frames
+_pool = hio.GeometryPool()
+
+
+def pool_key(ob):
+    # session_uid survives renames, unlike the object name
+    return str(ob.session_uid)
+
+
+def release_pool(keep=None):
+    # Drops the details of every key not in `keep` (all when None)
+    for key in _pool.keys():
+        if keep is None or key not in keep:
+            _pool.release(key)
+
+
 def import_(path: str, ob, opts):
     data = None
 
     temp_name = "temp_" + os.path.basename(path)
 
-    geo = hio.Geometry()
+    pool_key = opts.get("pool_key")
+    geo = _pool.acquire(pool_key) if pool_key else hio.Geometry()
     if not geo.load(path):
         return None
 
-    if ob.type == "MESH":
+    if ob.type == "MESH" and geo.isPointCloud():
+        data = import_points(geo, temp_name, opts)
+
+    elif ob.type == "MESH":
         data = import_mesh(geo, temp_name, opts)
         for x in ob.data.materials:
             data.materials.append(x)
+        assign_materials(data)
 
     elif ob.type == 'CURVE':
         data = import_curve(geo, temp_name, opts)